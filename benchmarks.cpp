@@ -0,0 +1,1887 @@
+// Benchmarks for the N&T SHOP data structures.
+// Build separately from the interactive program:
+//   g++ -std=c++17 -O2 -pthread -o benchmarks benchmarks.cpp
+// Usage:
+//   benchmarks [--suite name,...] [--sizes n,...] [--csv file] [--json file]
+// With no --suite every suite runs. --sizes sets the dataset sizes of the
+// "core" suite (default 1000,10000,100000,1000000; 10000000 needs several GB).
+// --csv and --json write that suite's results for comparing builds.
+#define NTSHOP_NO_MAIN
+#include "project code.cpp"
+
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <malloc.h>
+
+typedef chrono::steady_clock BenchClock;
+
+static double elapsedNs(BenchClock::time_point start) {
+    return chrono::duration<double, nano>(BenchClock::now() - start).count();
+}
+
+// Keeps the optimizer from discarding benchmark results
+static volatile long long benchSink = 0;
+
+// Every heap allocation the benchmark program makes goes through here. Kept
+// out of line so GCC does not pair the inlined free with new and warn. The
+// count is atomic because the server benchmark allocates on several threads.
+static atomic<long long> heapAllocations(0);
+
+__attribute__((noinline)) void* operator new(size_t size) {
+    heapAllocations.fetch_add(1, memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (!p) throw bad_alloc();
+    return p;
+}
+__attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { free(p); }
+
+// Resident set size of this process in KB (Linux only, 0 elsewhere)
+static long residentKb() {
+    ifstream status("/proc/self/status");
+    string key;
+    while (status >> key) {
+        if (key == "VmRSS:") {
+            long kb = 0;
+            status >> kb;
+            return kb;
+        }
+    }
+    return 0;
+}
+
+// Runs NTSHOP against a scratch directory so the data files of a real shop
+// in the working directory are never touched
+class BenchDir {
+    string path;
+    string previous;
+public:
+    BenchDir() {
+        char cwd[4096];
+        previous = getcwd(cwd, sizeof(cwd)) ? cwd : ".";
+        char pattern[] = "/tmp/ntshop-bench-XXXXXX";
+        path = mkdtemp(pattern) ? pattern : ".";
+        if (chdir(path.c_str()) != 0) path = ".";
+    }
+    ~BenchDir() {
+        if (chdir(previous.c_str()) != 0) return;
+        if (path != ".") system(("rm -rf " + path).c_str());
+    }
+};
+
+// Silences the shop's console messages while a benchmark drives it
+class QuietCout {
+    streambuf* saved;
+public:
+    QuietCout() : saved(cout.rdbuf()) { cout.rdbuf(NULL); }
+    ~QuietCout() { cout.clear(); cout.rdbuf(saved); }
+};
+
+// ========== PRODUCT ID LOOKUP ==========
+// getProductById goes through IdIndex; the linear scan it replaced is timed
+// alongside it on the same keys for comparison.
+void benchProductLookup() {
+    cout << "\n--- getProductById: hashed index vs linear scan ---" << endl;
+    cout << setw(10) << "products" << setw(16) << "index ns/op" << setw(16) << "scan ns/op" << endl;
+
+    mt19937 rng(42);
+    for (int n = 1000; n <= 1000000; n *= 10) {
+        vector<int> ids(n);
+        for (int i = 0; i < n; ++i) ids[i] = 1 + i * 7;  // sparse, like hand-assigned IDs
+
+        IdIndex index;
+        for (int i = 0; i < n; ++i) index.insert(ids[i], i);
+
+        const int lookups = 1000000;
+        vector<int> keys(lookups);
+        for (int i = 0; i < lookups; ++i) keys[i] = ids[rng() % n];
+
+        BenchClock::time_point start = BenchClock::now();
+        long long sum = 0;
+        for (int i = 0; i < lookups; ++i) sum += index.find(keys[i]);
+        double indexNs = elapsedNs(start) / lookups;
+        benchSink += sum;
+
+        // The scan is O(n) per lookup, so fewer lookups keep the run short
+        int scanLookups = n >= 100000 ? 200 : 2000;
+        start = BenchClock::now();
+        sum = 0;
+        for (int i = 0; i < scanLookups; ++i) {
+            for (int j = 0; j < n; ++j) {
+                if (ids[j] == keys[i]) { sum += j; break; }
+            }
+        }
+        double scanNs = elapsedNs(start) / scanLookups;
+        benchSink += sum;
+
+        cout << setw(10) << n << setw(16) << fixed << setprecision(1) << indexNs
+             << setw(16) << scanNs << endl;
+    }
+}
+
+// ========== USERNAME LOOKUP ==========
+// findUser and the registration duplicate check go through NameIndex.
+void benchUserLookup() {
+    cout << "\n--- findUser / registerCustomer: hashed username index ---" << endl;
+    cout << setw(10) << "users" << setw(16) << "insert ns/op" << setw(16) << "hit ns/op"
+         << setw(16) << "miss ns/op" << setw(16) << "scan ns/op" << endl;
+
+    mt19937 rng(7);
+    for (int n = 1000; n <= 1000000; n *= 10) {
+        vector<string> names(n);
+        for (int i = 0; i < n; ++i) names[i] = "user" + to_string(i);
+
+        BenchClock::time_point start = BenchClock::now();
+        NameIndex index;
+        for (int i = 0; i < n; ++i) index.insert(&names[i], i);
+        double insertNs = elapsedNs(start) / n;
+
+        const int lookups = 1000000;
+        vector<string> hits(lookups), misses(lookups);
+        for (int i = 0; i < lookups; ++i) {
+            hits[i] = names[rng() % n];
+            misses[i] = "nobody" + to_string(i);
+        }
+
+        start = BenchClock::now();
+        long long sum = 0;
+        for (int i = 0; i < lookups; ++i) sum += index.find(hits[i]);
+        double hitNs = elapsedNs(start) / lookups;
+
+        start = BenchClock::now();
+        for (int i = 0; i < lookups; ++i) sum += index.find(misses[i]);
+        double missNs = elapsedNs(start) / lookups;
+
+        int scanLookups = n >= 100000 ? 100 : 1000;
+        start = BenchClock::now();
+        for (int i = 0; i < scanLookups; ++i) {
+            for (int j = 0; j < n; ++j) {
+                if (names[j] == hits[i]) { sum += j; break; }
+            }
+        }
+        double scanNs = elapsedNs(start) / scanLookups;
+        benchSink += sum;
+
+        cout << setw(10) << n << setw(16) << fixed << setprecision(1) << insertNs
+             << setw(16) << hitNs << setw(16) << missNs << setw(16) << scanNs << endl;
+    }
+}
+
+// ========== GROWABLE ORDER STORAGE ==========
+// Places millions of orders through placeOrder now that storage is no longer
+// capped, checking every order is kept and indexed under its customer.
+void benchOrderGrowth() {
+    cout << "\n--- placeOrder at scale: growable storage ---" << endl;
+    cout << setw(10) << "orders" << setw(16) << "ns/order" << setw(16) << "bytes/order"
+         << setw(10) << "check" << endl;
+
+    const int customers = 10000;
+    for (int n = 100000; n <= 2000000; n *= 20) {
+        BenchDir dir;
+        long rssBefore = 0;
+        double perOrderNs = 0.0, bytesPerOrder = 0.0;
+        bool ok = true;
+        {
+            QuietCout quiet;
+            NTSHOP shop;
+            for (int c = 0; c < customers; ++c) shop.registerCustomer("cust" + to_string(c), "pass123");
+
+            Product* product = shop.getProductById(62);
+            CartItem cart[2] = { CartItem(product, 1), CartItem(shop.getProductById(3), 2) };
+            rssBefore = residentKb();
+
+            BenchClock::time_point start = BenchClock::now();
+            for (int i = 0; i < n; ++i) {
+                shop.placeOrder("cust" + to_string(i % customers), "House 1 Street 2", cart, 2,
+                                PAYMENT_COD, DELIVERY_NORMAL, 100400.0);
+            }
+            perOrderNs = elapsedNs(start) / n;
+
+            long indexed = 0;
+            for (int c = 0; c < customers; ++c) indexed += shop.getOrderSlotsOf("cust" + to_string(c)).size();
+            ok = shop.getOrderCount() == n && indexed == n;
+
+            bytesPerOrder = (residentKb() - rssBefore) * 1024.0 / n;
+        }
+        cout << setw(10) << n << setw(16) << fixed << setprecision(1) << perOrderNs
+             << setw(16) << bytesPerOrder << setw(10) << (ok ? "ok" : "FAILED") << endl;
+    }
+}
+
+// ========== CHECKOUT PERSISTENCE ==========
+// A checkout now appends one journal line; before, it rewrote every data file.
+// Both costs are measured against a shop that already holds n orders.
+void benchCheckoutJournal() {
+    cout << "\n--- checkout persistence: journal append vs full save ---" << endl;
+    cout << setw(10) << "orders" << setw(18) << "append us/order" << setw(18) << "full save us" << endl;
+
+    for (int n = 1000; n <= 1000000; n *= 10) {
+        BenchDir dir;
+        double appendUs = 0.0, saveUs = 0.0;
+        {
+            QuietCout quiet;
+            NTSHOP shop;
+            shop.registerCustomer("buyer1", "pass123");
+            CartItem cart[1] = { CartItem(shop.getProductById(62), 1) };
+            for (int i = 0; i < n; ++i) {
+                shop.placeOrder("buyer1", "House 1 Street 2", cart, 1, PAYMENT_ADVANCE, DELIVERY_NORMAL, 98000.0);
+            }
+            shop.saveData();
+
+            const int checkouts = 1000;
+            BenchClock::time_point start = BenchClock::now();
+            for (int i = 0; i < checkouts; ++i) {
+                shop.placeOrder("buyer1", "House 1 Street 2", cart, 1, PAYMENT_ADVANCE, DELIVERY_NORMAL, 98000.0);
+            }
+            appendUs = elapsedNs(start) / checkouts / 1000.0;
+
+            start = BenchClock::now();
+            shop.saveData();
+            saveUs = elapsedNs(start) / 1000.0;
+        }
+        cout << setw(10) << n << setw(18) << fixed << setprecision(2) << appendUs
+             << setw(18) << saveUs << endl;
+    }
+}
+
+// ========== STARTUP ==========
+// Constructs a shop from shop.snap and from the text files holding the same
+// data
+void benchStartup() {
+    cout << "\n--- NTSHOP startup: binary snapshot vs text files ---" << endl;
+    cout << setw(10) << "orders" << setw(16) << "snapshot ms" << setw(16) << "text ms" << endl;
+
+    for (int n = 1000; n <= 1000000; n *= 10) {
+        BenchDir dir;
+        double snapshotMs = 0.0, textMs = 0.0;
+        {
+            QuietCout quiet;
+            {
+                NTSHOP shop;
+                for (int c = 0; c < 1000; ++c) shop.registerCustomer("cust" + to_string(c), "pass123");
+                CartItem cart[1] = { CartItem(shop.getProductById(62), 1) };
+                for (int i = 0; i < n; ++i) {
+                    shop.placeOrder("cust" + to_string(i % 1000), "House " + to_string(i % 1000) + " Street 2",
+                                    cart, 1, PAYMENT_ADVANCE, DELIVERY_NORMAL, 98000.0);
+                }
+            }  // the destructor writes both formats
+
+            // Only the constructor is timed, not the destructor's save
+            BenchClock::time_point start = BenchClock::now();
+            NTSHOP* shop = new NTSHOP();
+            snapshotMs = elapsedNs(start) / 1e6;
+            benchSink += shop->getOrderCount();
+            delete shop;
+
+            remove(SNAPSHOT_FILE.c_str());
+            start = BenchClock::now();
+            shop = new NTSHOP();
+            textMs = elapsedNs(start) / 1e6;
+            benchSink += shop->getOrderCount();
+            delete shop;
+        }
+        cout << setw(10) << n << setw(16) << fixed << setprecision(2) << snapshotMs << setw(16) << textMs << endl;
+    }
+}
+
+// ========== TEXT PARSING THROUGHPUT ==========
+// The loaders before LineReader: a 256-byte getline buffer, a std::string
+// copy, a stringstream and one std::string per token, then stoi/stod
+static long long legacyParseOrders(const string& path) {
+    ifstream inFile(path);
+    long long parsed = 0;
+    char line[256];
+    while (inFile.getline(line, 256)) {
+        string strLine(line);
+        if (strLine.empty()) continue;
+        stringstream ss(strLine);
+        string token;
+        string tokens[9];
+        int tokenCount = 0;
+        while (getline(ss, token, '|') && tokenCount < 9) tokens[tokenCount++] = token;
+        if (tokenCount < 9) continue;
+        Order order;
+        order.restore(stoi(tokens[0]), tokens[1], tokens[2], stoi(tokens[3]), stod(tokens[4]),
+                      (DeliveryType)lookupName(tokens[5], DELIVERY_TYPE_NAMES, NUM_DELIVERY_TYPES), stod(tokens[6]),
+                      (PaymentMethod)lookupName(tokens[7], PAYMENT_METHOD_NAMES, NUM_PAYMENT_METHODS),
+                      (OrderStatus)lookupName(tokens[8], ORDER_STATUS_NAMES, NUM_ORDER_STATUSES));
+        parsed += order.getId();
+    }
+    return parsed;
+}
+
+static long long streamingParseOrders(const string& path) {
+    LineReader reader(path);
+    long long parsed = 0;
+    string_view line;
+    while (reader.next(line)) {
+        Order order;
+        if (order.fromFileString(line)) parsed += order.getId();
+    }
+    return parsed;
+}
+
+void benchTextParsing() {
+    cout << "\n--- orders.txt parsing throughput ---" << endl;
+    cout << setw(10) << "orders" << setw(12) << "MB" << setw(16) << "legacy MB/s"
+         << setw(16) << "stream MB/s" << setw(10) << "check" << endl;
+
+    for (int n = 10000; n <= 1000000; n *= 10) {
+        BenchDir dir;
+        {
+            ofstream out("orders.txt");
+            for (int i = 0; i < n; ++i) {
+                out << (1001 + i) << "|cust" << (i % 1000) << "|House " << (i % 977)
+                    << " Street 2, Gulberg III, Lahore|2|" << (1200.5 + i % 5000) << "|Normal|0|Cash on Delivery (COD)|Placed\n";
+            }
+        }
+        double mb = 0.0;
+        {
+            ifstream in("orders.txt", ios::binary | ios::ate);
+            mb = in.tellg() / 1e6;
+        }
+
+        BenchClock::time_point start = BenchClock::now();
+        long long legacy = legacyParseOrders("orders.txt");
+        double legacySec = elapsedNs(start) / 1e9;
+
+        start = BenchClock::now();
+        long long streamed = streamingParseOrders("orders.txt");
+        double streamSec = elapsedNs(start) / 1e9;
+        benchSink += legacy + streamed;
+
+        cout << setw(10) << n << setw(12) << fixed << setprecision(1) << mb
+             << setw(16) << mb / legacySec << setw(16) << mb / streamSec
+             << setw(10) << (legacy == streamed ? "ok" : "MISMATCH") << endl;
+    }
+}
+
+// ========== PRODUCT KEYWORD SEARCH ==========
+// Builds the inverted index over a synthetic catalog and runs one-, two- and
+// three-word AND queries. Every query is checked against a brute-force scan.
+void benchProductSearch() {
+    cout << "\n--- product keyword search: inverted index ---" << endl;
+    cout << setw(10) << "products" << setw(12) << "build ms" << setw(12) << "rare us"
+         << setw(14) << "rare+AND us" << setw(14) << "broad AND us" << setw(14) << "3-word us"
+         << setw(10) << "check" << endl;
+
+    const char* adjectives[] = { "leather", "cotton", "wireless", "smart", "classic", "premium",
+                                 "compact", "heavy", "digital", "portable", "steel", "kids" };
+    const char* nouns[] = { "jacket", "shoes", "speaker", "watch", "lamp", "bag", "charger",
+                            "helmet", "notebook", "kettle", "mouse", "cover", "tyre", "belt" };
+    const char* subs[] = { "Accessories", "Audio", "Footwear", "Office Supplies", "Interior",
+                           "Home Appliances", "Bags", "Winter Wear" };
+    const int nAdj = 12, nNoun = 14, nSub = 8;
+
+    mt19937 rng(3);
+    for (int n = 10000; n <= 1000000; n *= 10) {
+        vector<string> names(n), subCats(n);
+        for (int i = 0; i < n; ++i) {
+            names[i] = string(adjectives[rng() % nAdj]) + " " + nouns[rng() % nNoun] + " model" + to_string(rng() % (n / 10 + 1));
+            subCats[i] = subs[rng() % nSub];
+        }
+
+        BenchClock::time_point start = BenchClock::now();
+        ProductSearchIndex index;
+        for (int i = 0; i < n; ++i) index.add(i, names[i], subCats[i]);
+        double buildMs = elapsedNs(start) / 1e6;
+
+        // Selective queries (a model number) against broad ones (two common
+        // words, each in about 1/12 of the catalog); broad ones are bounded
+        // by the size of their result
+        string queries[4][4] = {
+            { "model17", "model4242", "model99", "model7" },
+            { "model17 leather", "wireless model4242", "model99 watch", "kids model7" },
+            { "leather jacket", "wireless speaker", "smart watch", "steel belt" },
+            { "leather jacket accessories", "wireless speaker audio", "kids shoes footwear", "premium lamp interior" }
+        };
+        double perQueryUs[4];
+        bool ok = true;
+        for (int q = 0; q < 4; ++q) {
+            const int rounds = 20;
+            start = BenchClock::now();
+            for (int r = 0; r < rounds; ++r)
+                for (int k = 0; k < 4; ++k) benchSink += index.search(queries[q][k]).size();
+            perQueryUs[q] = elapsedNs(start) / (rounds * 4) / 1000.0;
+
+            // Brute force check on the same catalog
+            for (int k = 0; k < 4; ++k) {
+                vector<string> words = ProductSearchIndex::tokenize(queries[q][k]);
+                vector<int> expected;
+                for (int i = 0; i < n; ++i) {
+                    vector<string> have = ProductSearchIndex::tokenize(names[i] + " " + subCats[i]);
+                    bool all = true;
+                    for (size_t w = 0; w < words.size() && all; ++w)
+                        all = find(have.begin(), have.end(), words[w]) != have.end();
+                    if (all) expected.push_back(i);
+                }
+                if (expected != index.search(queries[q][k])) ok = false;
+            }
+        }
+
+        cout << setw(10) << n << setw(12) << fixed << setprecision(1) << buildMs
+             << setw(12) << setprecision(2) << perQueryUs[0] << setw(14) << perQueryUs[1]
+             << setw(14) << perQueryUs[2] << setw(14) << perQueryUs[3]
+             << setw(10) << (ok ? "ok" : "MISMATCH") << endl;
+    }
+}
+
+// ========== CUSTOMER ADDRESS SEARCH ==========
+// Substring search over customer addresses: the trigram index plus the same
+// confirmation NTSHOP::findCustomersByAddress does, against a full scan.
+void benchAddressSearch() {
+    cout << "\n--- searchCustomer by address: trigram index vs scan ---" << endl;
+    cout << setw(10) << "customers" << setw(12) << "build ms" << setw(14) << "update us"
+         << setw(14) << "index us" << setw(14) << "scan us" << setw(10) << "check" << endl;
+
+    const char* areas[] = { "Gulberg III", "Model Town", "DHA Phase 5", "Johar Town", "Clifton",
+                            "Satellite Town", "Bahria Town", "Saddar", "Cantt", "F-7 Markaz" };
+    const char* cities[] = { "Lahore", "Karachi", "Islamabad", "Rawalpindi", "Multan", "Peshawar" };
+
+    mt19937 rng(11);
+    for (int n = 10000; n <= 1000000; n *= 10) {
+        vector<string> addresses(n);
+        for (int i = 0; i < n; ++i) {
+            addresses[i] = "House " + to_string(rng() % 2000) + " Street " + to_string(rng() % 500) + ", "
+                         + areas[rng() % 10] + ", " + cities[rng() % 6];
+        }
+
+        BenchClock::time_point start = BenchClock::now();
+        TrigramIndex index;
+        for (int i = 0; i < n; ++i) index.add(i, addresses[i]);
+        double buildMs = elapsedNs(start) / 1e6;
+
+        // Checkout changes an address: drop the old trigrams, add the new ones
+        const int updates = 10000;
+        start = BenchClock::now();
+        for (int u = 0; u < updates; ++u) {
+            int slot = rng() % n;
+            index.remove(slot, addresses[slot]);
+            addresses[slot] = "Flat " + to_string(u) + ", " + areas[u % 10] + ", " + cities[u % 6];
+            index.add(slot, addresses[slot]);
+        }
+        double updateUs = elapsedNs(start) / updates / 1000.0;
+
+        // The last query matches about 1/60 of all customers
+        const string queries[] = { "House 1234 Street", "Street 42,", "Flat 777,", "F-7 Markaz, Lahore" };
+        const int nQueries = 4;
+        // First reads merge the entries appended by the updates; time the steady state
+        for (int q = 0; q < nQueries; ++q) benchSink += index.candidates(queries[q]).size();
+        double indexUs = 0.0, scanUs = 0.0;
+        bool ok = true;
+        for (int q = 0; q < nQueries; ++q) {
+            start = BenchClock::now();
+            vector<int> viaIndex;
+            vector<int> cands = index.candidates(queries[q]);
+            for (size_t i = 0; i < cands.size(); ++i)
+                if (addresses[cands[i]].find(queries[q]) != string::npos) viaIndex.push_back(cands[i]);
+            indexUs += elapsedNs(start) / 1000.0;
+
+            start = BenchClock::now();
+            vector<int> viaScan;
+            for (int i = 0; i < n; ++i)
+                if (addresses[i].find(queries[q]) != string::npos) viaScan.push_back(i);
+            scanUs += elapsedNs(start) / 1000.0;
+
+            if (viaIndex != viaScan) ok = false;
+        }
+
+        cout << setw(10) << n << setw(12) << fixed << setprecision(1) << buildMs
+             << setw(14) << setprecision(2) << updateUs << setw(14) << indexUs / nQueries
+             << setw(14) << scanUs / nQueries << setw(10) << (ok ? "ok" : "MISMATCH") << endl;
+    }
+}
+
+// ========== CATEGORY BROWSING ==========
+// A catalog where one category is small: browsing it walks only that
+// category's slots, where the old path string-compared every product. The
+// summary reads four counters instead of re-scanning.
+void benchCategoryIndex() {
+    cout << "\n--- category browse and summary: per-category index vs scan ---" << endl;
+    cout << setw(10) << "products" << setw(14) << "browse us" << setw(14) << "scan us"
+         << setw(14) << "summary us" << setw(10) << "check" << endl;
+
+    mt19937 rng(5);
+    for (int n = 10000; n <= 1000000; n *= 10) {
+        BenchDir dir;
+        double browseUs = 0.0, scanUs = 0.0, summaryUs = 0.0;
+        bool ok = true;
+        {
+            QuietCout quiet;
+            NTSHOP shop;
+            // Education stays at a fixed 100 products; the rest share the remainder
+            for (int i = 0; i < n; ++i) {
+                int type = i < 100 ? 1 : (rng() % 2 == 0 ? 0 : 2 + rng() % 2);
+                shop.addProduct(NTSHOP::createProduct(type, 1000 + i, "Item " + to_string(i), 500.0 + i % 900, "General"));
+            }
+            vector<Product*> all;
+            for (int i = 0; i < n; ++i) all.push_back(shop.getProductById(1000 + i));
+
+            const int rounds = 100;
+            BenchClock::time_point start = BenchClock::now();
+            for (int r = 0; r < rounds; ++r) {
+                const vector<int>& slots = shop.getProductSlotsInCategory(CATEGORY_EDUCATION);
+                for (size_t i = 0; i < slots.size(); ++i) benchSink += slots[i];
+            }
+            browseUs = elapsedNs(start) / rounds / 1000.0;
+
+            const int scanRounds = 10;
+            vector<int> viaScan;
+            start = BenchClock::now();
+            for (int r = 0; r < scanRounds; ++r) {
+                viaScan.clear();
+                for (int i = 0; i < (int)all.size(); ++i)
+                    if (all[i]->getCategoryName() == "Education") viaScan.push_back(i + 80);  // after the defaults
+            }
+            scanUs = elapsedNs(start) / scanRounds / 1000.0;
+
+            start = BenchClock::now();
+            for (int r = 0; r < rounds; ++r) shop.displayCategorySummary();
+            summaryUs = elapsedNs(start) / rounds / 1000.0;
+
+            // The 20 default Education products come first in the index
+            const vector<int>& slots = shop.getProductSlotsInCategory(CATEGORY_EDUCATION);
+            ok = slots.size() == viaScan.size() + 20 && equal(viaScan.begin(), viaScan.end(), slots.begin() + 20);
+        }
+        cout << setw(10) << n << setw(14) << fixed << setprecision(2) << browseUs
+             << setw(14) << scanUs << setw(14) << summaryUs << setw(10) << (ok ? "ok" : "MISMATCH") << endl;
+    }
+}
+
+// ========== PRICE ORDER ==========
+// Price band and top-k queries through the price index, against filtering
+// every product of the category and sorting the matches, on catalogs of 10^5
+// and 10^6 products. "sort ms" is the first query, which sorts the whole
+// catalog; "add+query ms" adds 1000 more products and queries again. The
+// check is that every query returns the same products as the scan.
+static vector<Product*> scanByPrice(const vector<Product*>& all, int category, double minPrice, double maxPrice,
+                                    bool descending, size_t offset, size_t count) {
+    vector<pair<double, int> > band;
+    for (int i = 0; i < (int)all.size(); ++i) {
+        double price = all[i]->getBasePrice();
+        if ((category == ANY_CATEGORY || all[i]->getCategory() == category) && price >= minPrice && price <= maxPrice)
+            band.push_back(make_pair(price, i));
+    }
+    sort(band.begin(), band.end());
+    if (descending) reverse(band.begin(), band.end());
+    vector<Product*> page;
+    for (size_t i = offset; i < band.size() && i - offset < count; ++i) page.push_back(all[band[i].second]);
+    return page;
+}
+
+void benchPriceIndex() {
+    cout << "\n--- products by price: price index vs filter and sort ---" << endl;
+    cout << setw(10) << "products" << setw(12) << "sort ms" << setw(14) << "band scan us" << setw(14) << "band us"
+         << setw(14) << "top-5 scan us" << setw(12) << "top-5 us" << setw(14) << "add+query ms" << setw(10) << "check"
+         << endl;
+
+    mt19937 rng(25);
+    for (int n = 100000; n <= 1000000; n *= 10) {
+        BenchDir dir;
+        double sortMs, bandScanUs, bandUs, topScanUs, topUs, addMs;
+        bool ok = true;
+        {
+            QuietCout quiet;
+            NTSHOP shop;
+            vector<Product*> all;
+            for (int id = 1; id <= 80; ++id) all.push_back(shop.getProductById(id));  // the default catalog
+            for (int i = 0; i < n; ++i) {
+                Product* p = NTSHOP::createProduct(rng() % 4, 1000 + i, "Item " + to_string(i),
+                                                   100.0 + rng() % 1000000 / 10.0, "General");
+                shop.addProduct(p);
+                all.push_back(p);
+            }
+
+            BenchClock::time_point start = BenchClock::now();
+            benchSink += shop.countProductsInPriceRange(ANY_CATEGORY, 0.0, HUGE_VAL);
+            sortMs = elapsedNs(start) / 1e6;
+
+            // A page of PRODUCTS_PER_PAGE from a PKR 5000 wide band, at a random page of it
+            const int queries = 100;
+            vector<int> categories(queries), offsets(queries);
+            vector<double> lows(queries);
+            vector<bool> descending(queries);
+            for (int q = 0; q < queries; ++q) {
+                categories[q] = (int)(rng() % 5) - 1;
+                lows[q] = 100.0 + rng() % 95000;
+                descending[q] = rng() % 2 == 1;
+                offsets[q] = PRODUCTS_PER_PAGE * (int)(rng() % 8);
+            }
+            vector<vector<Product*> > scanned(queries), indexed(queries);
+            start = BenchClock::now();
+            for (int q = 0; q < queries; ++q)
+                scanned[q] = scanByPrice(all, categories[q], lows[q], lows[q] + 5000.0, descending[q], offsets[q],
+                                         PRODUCTS_PER_PAGE);
+            bandScanUs = elapsedNs(start) / queries / 1000.0;
+            start = BenchClock::now();
+            for (int q = 0; q < queries; ++q)
+                indexed[q] = shop.getProductsByPrice(categories[q], lows[q], lows[q] + 5000.0, descending[q],
+                                                     offsets[q], PRODUCTS_PER_PAGE);
+            bandUs = elapsedNs(start) / queries / 1000.0;
+            for (int q = 0; q < queries && ok; ++q) ok = indexed[q] == scanned[q] && !indexed[q].empty();
+
+            // The cheapest and the most expensive products of every category
+            vector<vector<Product*> > topScanned, topIndexed;
+            start = BenchClock::now();
+            for (int c = 0; c < NUM_CATEGORIES; ++c)
+                for (int dearest = 0; dearest < 2; ++dearest)
+                    topScanned.push_back(scanByPrice(all, c, 0.0, HUGE_VAL, dearest, 0, PRICE_EXTREMES_SHOWN));
+            topScanUs = elapsedNs(start) / (2 * NUM_CATEGORIES) / 1000.0;
+            start = BenchClock::now();
+            for (int c = 0; c < NUM_CATEGORIES; ++c)
+                for (int dearest = 0; dearest < 2; ++dearest)
+                    topIndexed.push_back(shop.getProductsByPrice(c, 0.0, HUGE_VAL, dearest, 0, PRICE_EXTREMES_SHOWN));
+            topUs = elapsedNs(start) / (2 * NUM_CATEGORIES) / 1000.0;
+            ok = ok && topIndexed == topScanned;
+
+            // New products are merged in by the next query
+            for (int i = 0; i < 1000; ++i) {
+                Product* p = NTSHOP::createProduct(rng() % 4, 1000 + n + i, "New " + to_string(i),
+                                                   100.0 + rng() % 1000000 / 10.0, "General");
+                all.push_back(p);
+            }
+            start = BenchClock::now();
+            for (int i = 0; i < 1000; ++i) shop.addProduct(all[all.size() - 1000 + i]);
+            vector<Product*> cheapest = shop.getProductsByPrice(ANY_CATEGORY, 0.0, HUGE_VAL, false, 0, 1000);
+            addMs = elapsedNs(start) / 1e6;
+            ok = ok && cheapest == scanByPrice(all, ANY_CATEGORY, 0.0, HUGE_VAL, false, 0, 1000) &&
+                 shop.countProductsInPriceRange(ANY_CATEGORY, 0.0, HUGE_VAL) == (int)all.size();
+        }
+        cout << setw(10) << n << setw(12) << fixed << setprecision(1) << sortMs << setw(14) << bandScanUs
+             << setw(14) << setprecision(2) << bandUs << setw(14) << setprecision(1) << topScanUs << setw(12)
+             << setprecision(2) << topUs << setw(14) << addMs << setw(10) << (ok ? "ok" : "MISMATCH") << endl;
+    }
+}
+
+// ========== ORDER FOOTPRINT ==========
+// Order as it was before status, delivery type and payment method became
+// one-byte codes: the same fields, with those three held as strings
+struct LegacyOrder {
+    int orderId;
+    string customerUsername;
+    string deliveryAddress;
+    vector<OrderLine> items;
+    int itemsCount;
+    double totalCost;
+    string deliveryType;
+    double deliveryCharge;
+    string paymentMethod;
+    string status;
+};
+
+// Fills 10^6 orders of each layout and filters the delivered ones, the
+// comparison displayDeliveredOrders makes for every order. Freed memory is
+// handed back to the system before each fill so one layout cannot reuse
+// pages the other left resident.
+void benchOrderFootprint() {
+    cout << "\n--- Order footprint: string fields vs one-byte codes ---" << endl;
+    cout << setw(10) << "layout" << setw(12) << "sizeof" << setw(16) << "bytes/order"
+         << setw(16) << "filter ns/op" << setw(10) << "check" << endl;
+
+    const int n = 1000000;
+    long long legacyDelivered = 0, codedDelivered = 0;
+    {
+        malloc_trim(0);
+        long rssBefore = residentKb();
+        vector<LegacyOrder> orders(n);
+        for (int i = 0; i < n; ++i) {
+            LegacyOrder& o = orders[i];
+            o.orderId = 1001 + i;
+            o.customerUsername = "cust" + to_string(i % 1000);
+            o.deliveryAddress = "House 1 Street 2";
+            o.itemsCount = 1;
+            o.totalCost = 98000.0;
+            o.deliveryType = DELIVERY_TYPE_NAMES[i % 2];
+            o.deliveryCharge = i % 2 ? 500.0 : 0.0;
+            o.paymentMethod = PAYMENT_METHOD_NAMES[i % 2];
+            o.status = ORDER_STATUS_NAMES[i % 3 == 0 ? 1 : 0];
+        }
+        double bytesPerOrder = (residentKb() - rssBefore) * 1024.0 / n;
+
+        BenchClock::time_point start = BenchClock::now();
+        for (int i = 0; i < n; ++i)
+            if (orders[i].status == "Delivered") legacyDelivered++;
+        double filterNs = elapsedNs(start) / n;
+
+        cout << setw(10) << "strings" << setw(12) << sizeof(LegacyOrder) << setw(16) << fixed
+             << setprecision(1) << bytesPerOrder << setw(16) << setprecision(2) << filterNs << setw(10) << "-" << endl;
+    }
+    {
+        malloc_trim(0);
+        long rssBefore = residentKb();
+        vector<Order> orders(n);
+        for (int i = 0; i < n; ++i) {
+            orders[i].restore(1001 + i, "cust" + to_string(i % 1000), "House 1 Street 2", 1, 98000.0,
+                              (DeliveryType)(i % 2), i % 2 ? 500.0 : 0.0, (PaymentMethod)(i % 2),
+                              i % 3 == 0 ? STATUS_DELIVERED : STATUS_PLACED);
+        }
+        double bytesPerOrder = (residentKb() - rssBefore) * 1024.0 / n;
+
+        BenchClock::time_point start = BenchClock::now();
+        for (int i = 0; i < n; ++i)
+            if (orders[i].getStatus() == STATUS_DELIVERED) codedDelivered++;
+        double filterNs = elapsedNs(start) / n;
+
+        cout << setw(10) << "codes" << setw(12) << sizeof(Order) << setw(16) << fixed
+             << setprecision(1) << bytesPerOrder << setw(16) << setprecision(2) << filterNs
+             << setw(10) << (codedDelivered == legacyDelivered ? "ok" : "MISMATCH") << endl;
+    }
+    benchSink += legacyDelivered + codedDelivered;
+}
+
+// ========== BATCH PRICING ==========
+// Prices every product of a catalog slice, and a batch of random quote lines,
+// through PriceTable and through one virtual calculatePrice call per line.
+// The two must agree exactly.
+void benchBatchPricing() {
+    cout << "\n--- pricing: batch PriceTable vs virtual calculatePrice ---" << endl;
+    cout << setw(10) << "products" << setw(16) << "slice ns/line" << setw(16) << "virtual ns"
+         << setw(16) << "quote ns/line" << setw(16) << "virtual ns" << setw(10) << "check" << endl;
+
+    mt19937 rng(13);
+    for (int n = 10000; n <= 1000000; n *= 10) {
+        BenchDir dir;
+        double sliceNs = 0.0, sliceVirtualNs = 0.0, quoteNs = 0.0, quoteVirtualNs = 0.0;
+        bool ok = true;
+        {
+            QuietCout quiet;
+            NTSHOP shop;
+            for (int i = 0; i < n; ++i)
+                shop.addProduct(NTSHOP::createProduct(rng() % 4, 1000 + i, "Item", 100.0 + (rng() % 1000000) / 100.0, "General"));
+            const PriceTable& table = shop.getPriceTable();
+            Product** products = shop.getProductArray();
+            size_t count = table.size();
+
+            // Catalog-wide repricing at each quantity from 1 to 5
+            vector<double> batch(count), single(count);
+            for (int q = 1; q <= 5; ++q) {
+                BenchClock::time_point start = BenchClock::now();
+                table.priceSlice(0, count, q, batch.data());
+                sliceNs += elapsedNs(start) / count / 5;
+
+                start = BenchClock::now();
+                for (size_t i = 0; i < count; ++i) single[i] = products[i]->calculatePrice(q);
+                sliceVirtualNs += elapsedNs(start) / count / 5;
+
+                if (batch != single) ok = false;
+            }
+
+            // Bulk quote of random lines
+            const int lines = 1000000;
+            vector<int> slots(lines);
+            vector<int32_t> quantities(lines);
+            for (int i = 0; i < lines; ++i) {
+                slots[i] = rng() % count;
+                quantities[i] = 1 + rng() % 5;
+            }
+            vector<double> quoted(lines), expected(lines);
+            BenchClock::time_point start = BenchClock::now();
+            table.quote(slots.data(), quantities.data(), quoted.data(), lines);
+            quoteNs = elapsedNs(start) / lines;
+
+            start = BenchClock::now();
+            for (int i = 0; i < lines; ++i) expected[i] = products[slots[i]]->calculatePrice(quantities[i]);
+            quoteVirtualNs = elapsedNs(start) / lines;
+
+            if (quoted != expected) ok = false;
+            benchSink += (long long)(batch[count / 2] + quoted[lines / 2]);
+        }
+        cout << setw(10) << n << setw(16) << fixed << setprecision(2) << sliceNs << setw(16) << sliceVirtualNs
+             << setw(16) << quoteNs << setw(16) << quoteVirtualNs << setw(10) << (ok ? "ok" : "MISMATCH") << endl;
+    }
+}
+
+// ========== CHECKOUT ALLOCATIONS ==========
+// Counts the heap allocations made by placeOrder. The shop already holds
+// more orders than are placed here, so no checkpoint falls in the measured
+// run; the only allocations left should be the tables growing.
+void benchCheckoutAllocations() {
+    cout << "\n--- placeOrder heap allocations ---" << endl;
+    cout << setw(12) << "checkouts" << setw(14) << "allocations" << setw(16) << "allocs/order"
+         << setw(18) << "orders allocating" << setw(10) << "check" << endl;
+
+    BenchDir dir;
+    const int preload = 200000, checkouts = 100000;
+    long long allocations = 0;
+    int allocating = 0;
+    {
+        QuietCout quiet;
+        NTSHOP shop;
+        vector<string> names, addresses;
+        for (int c = 0; c < 10; ++c) {
+            names.push_back("cust" + to_string(c));
+            addresses.push_back("House " + to_string(c) + " Street 2, Gulberg III, Lahore");
+            shop.registerCustomer(names[c], "pass123");
+        }
+        CartItem cart[3] = { CartItem(shop.getProductById(62), 3), CartItem(shop.getProductById(41), 1),
+                             CartItem(shop.getProductById(5), 2) };
+        for (int i = 0; i < preload; ++i)
+            shop.placeOrder(names[i % 10], addresses[i % 10], cart, 3, PAYMENT_COD, DELIVERY_URGENT, 1000.0);
+        shop.saveData();
+
+        for (int i = 0; i < checkouts; ++i) {
+            long long before = heapAllocations;
+            shop.placeOrder(names[i % 10], addresses[i % 10], cart, 3, PAYMENT_COD, DELIVERY_URGENT, 1000.0);
+            long long made = heapAllocations - before;
+            allocations += made;
+            if (made > 0) allocating++;
+        }
+    }
+    cout << setw(12) << checkouts << setw(14) << allocations << setw(16) << fixed << setprecision(4)
+         << (double)allocations / checkouts << setw(18) << allocating
+         << setw(10) << (allocating * 1000 < checkouts ? "ok" : "FAILED") << endl;
+}
+
+// ========== LISTING OUTPUT ==========
+// Rows per second for the product and order listings, written to /dev/null
+// so the terminal's speed does not enter into it. The legacy renderers are
+// the cout << ... << endl code the listings used before RenderBuffer, which
+// flushed the stream after every line. The check compares their text with
+// the buffered listing. "page us" is the time to show one page.
+static void legacyRenderProduct(ostream& out, const Product* p) {
+    out << "[ID: " << p->getId() << "] " << p->getName() << " | Category: " << p->getCategoryName()
+        << " (" << p->getSubCategory() << ") | Price: PKR " << fixed << setprecision(2) << p->getBasePrice() << endl;
+}
+
+static void legacyRenderOrder(ostream& out, const Order& o, const OrderLine* lines) {
+    out << "\n--- Order ID: " << o.getId() << " ---" << endl;
+    out << "  Customer: " << o.getUsername() << endl;
+    out << "  Address: " << o.getAddress() << endl;
+    out << "  Delivery Type: " << o.getDeliveryTypeName() << " (" << (o.getDeliveryType() == DELIVERY_URGENT ? "3 days" : "5 days") << ")" << endl;
+    out << "  Payment: " << o.getPaymentMethodName() << endl;
+    out << "  Status: " << o.getStatusName() << endl;
+    out << "  Items:" << endl;
+    for (uint32_t i = 0; i < o.getLineCount(); ++i) {
+        out << "    - ";
+        if (lines[i].product) out << lines[i].product->getName();
+        else out << "Product #" << lines[i].productId;
+        out << " x " << lines[i].quantity << " @ PKR " << fixed << setprecision(2) << lines[i].price << endl;
+    }
+    out << "  Delivery Charge: PKR " << fixed << setprecision(2) << o.getDeliveryCharge() << endl;
+    out << "  FINAL TOTAL: PKR " << fixed << setprecision(2) << o.getTotalCost() << endl;
+}
+
+void benchListingOutput() {
+    cout << "\n--- listings: RenderBuffer vs cout/endl per line ---" << endl;
+    cout << setw(10) << "listing" << setw(10) << "rows" << setw(16) << "legacy rows/s" << setw(16) << "buffer rows/s"
+         << setw(12) << "page us" << setw(10) << "check" << endl;
+
+    BenchDir dir;
+    const int products = 100000, orders = 20000;
+    ofstream devNull("/dev/null");
+    double legacyProductRate = 0.0, bufferProductRate = 0.0, productPageUs = 0.0;
+    double legacyOrderRate = 0.0, bufferOrderRate = 0.0, orderPageUs = 0.0;
+    bool productsOk = true, ordersOk = true;
+    {
+        QuietCout quiet;
+        NTSHOP shop;
+        mt19937 rng(15);
+        for (int i = 0; i < products; ++i)
+            shop.addProduct(NTSHOP::createProduct(rng() % 4, 1000 + i, "Item " + to_string(i), 100.0 + (rng() % 1000000) / 100.0, "General"));
+        shop.registerCustomer("listing", "pass123");
+        CartItem cart[3] = { CartItem(shop.getProductById(62), 3), CartItem(shop.getProductById(41), 1),
+                             CartItem(shop.getProductById(5), 2) };
+        for (int i = 0; i < orders; ++i)
+            shop.placeOrder("listing", "House 7 Street 2, Gulberg III, Lahore", cart, 3, PAYMENT_COD, DELIVERY_URGENT, 1000.0);
+
+        Product** all = shop.getProductArray();
+        int productCount = shop.getProductCount(), orderCount = shop.getOrderCount();
+
+        // Same text either way; the header and footer lines are the listing's own
+        ostringstream legacyText, bufferText;
+        for (int i = 0; i < productCount; ++i) legacyRenderProduct(legacyText, all[i]);
+        cout.rdbuf(bufferText.rdbuf());
+        shop.displayAllProducts();
+        if (bufferText.str().find(legacyText.str()) == string::npos) productsOk = false;
+
+        legacyText.str(""); bufferText.str("");
+        for (int i = 0; i < orderCount; ++i) legacyRenderOrder(legacyText, shop.getOrderAt(i), shop.linesOf(shop.getOrderAt(i)));
+        shop.displayAllOrders();
+        if (bufferText.str() != legacyText.str()) ordersOk = false;
+
+        BenchClock::time_point start = BenchClock::now();
+        for (int i = 0; i < productCount; ++i) legacyRenderProduct(devNull, all[i]);
+        legacyProductRate = productCount / (elapsedNs(start) / 1e9);
+
+        cout.rdbuf(devNull.rdbuf());
+        start = BenchClock::now();
+        shop.displayAllProducts();
+        bufferProductRate = productCount / (elapsedNs(start) / 1e9);
+
+        start = BenchClock::now();
+        for (int i = 0; i < orderCount; ++i) legacyRenderOrder(devNull, shop.getOrderAt(i), shop.linesOf(shop.getOrderAt(i)));
+        legacyOrderRate = orderCount / (elapsedNs(start) / 1e9);
+
+        start = BenchClock::now();
+        shop.displayAllOrders();
+        bufferOrderRate = orderCount / (elapsedNs(start) / 1e9);
+
+        // A page from the middle of each listing
+        start = BenchClock::now();
+        shop.displayAllProducts(productCount / 2, PRODUCTS_PER_PAGE);
+        productPageUs = elapsedNs(start) / 1000;
+
+        start = BenchClock::now();
+        shop.displayAllOrders(orderCount / 2, ORDERS_PER_PAGE);
+        orderPageUs = elapsedNs(start) / 1000;
+    }
+    cout << setw(10) << "products" << setw(10) << products << setw(16) << fixed << setprecision(0) << legacyProductRate
+         << setw(16) << bufferProductRate << setw(12) << setprecision(1) << productPageUs
+         << setw(10) << (productsOk ? "ok" : "MISMATCH") << endl;
+    cout << setw(10) << "orders" << setw(10) << orders << setw(16) << setprecision(0) << legacyOrderRate
+         << setw(16) << bufferOrderRate << setw(12) << setprecision(1) << orderPageUs
+         << setw(10) << (ordersOk ? "ok" : "MISMATCH") << endl;
+}
+
+// ========== BATCH REPLAY ==========
+// A synthetic traffic capture run through BatchRunner: every customer
+// registers, logs in, searches, fills a cart and checks out, and an admin
+// marks every order delivered. The check is that each checkout produced an
+// order and each order got delivered.
+void benchBatchReplay() {
+    cout << "\n--- batch mode: synthetic command stream ---" << endl;
+    BenchDir dir;
+    const int customers = 20000;
+    const char* words[] = {"leather", "jacket", "laptop", "book", "car", "phone", "watch", "shoes"};
+    int firstId = Order::getNextOrderId();  // earlier suites in this run have used IDs too
+    {
+        ofstream script("commands.txt");
+        mt19937 rng(16);
+        script << "login|admin|admin123\n";
+        for (int c = 0; c < customers; ++c) {
+            string name = "cust" + to_string(c);
+            script << "register|" << name << "|pass123\n" << "login|" << name << "|pass123\n"
+                   << "search|" << words[rng() % 8] << ' ' << words[rng() % 8] << '\n';
+            for (int i = 0; i < 3; ++i) script << "add|" << name << '|' << 1 + rng() % 80 << '|' << 1 + rng() % 4 << '\n';
+            script << "checkout|" << name << '|' << (c % 2 ? "cod" : "advance") << '|' << (c % 3 ? "normal" : "urgent")
+                   << "|House " << c << " Street " << c % 50 << ", Lahore\n" << "logout|" << name << '\n';
+        }
+        for (int c = 0; c < customers; ++c) script << "deliver|" << firstId + c << '\n';
+    }
+
+    bool ok;
+    {
+        NTSHOP* shop;
+        {
+            QuietCout quiet;
+            shop = new NTSHOP();
+        }
+        BatchRunner batch(shop);
+        ok = batch.run("commands.txt");
+        batch.printReport();
+        ok = ok && shop->getOrderCount() == customers && shop->countOrdersWithStatus(STATUS_DELIVERED) == customers;
+        QuietCout quiet;
+        delete shop;
+    }
+    cout << "check: " << (ok ? "ok" : "MISMATCH") << endl;
+}
+
+// ========== SERVER LOAD ==========
+// A load-test client for server mode. The server runs in this process on a
+// free port; client threads each drive their share of the sessions over
+// their own connections, sending one request on every connection and then
+// collecting every reply. Each session registers and logs in, then repeats
+// search, add to cart and checkout. Latency is from a request being sent to
+// its reply line arriving.
+struct LoadConnection {
+    int fd;
+    string name;
+    string pending;  // received bytes past the last reply read
+
+    bool sendLine(const string& line) {
+        size_t sent = 0;
+        while (sent < line.size()) {
+            ssize_t n = send(fd, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            sent += n;
+        }
+        return true;
+    }
+
+    bool readReply(string& reply) {
+        size_t newline;
+        while ((newline = pending.find('\n')) == string::npos) {
+            char chunk[4096];
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) return false;
+            pending.append(chunk, n);
+        }
+        reply.assign(pending, 0, newline);
+        pending.erase(0, newline + 1);
+        return true;
+    }
+};
+
+static void runLoadClient(int port, int firstSession, int sessions, int rounds,
+                          vector<double>& latenciesNs, int& failures) {
+    vector<LoadConnection> connections(sessions);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int i = 0; i < sessions; ++i) {
+        LoadConnection& c = connections[i];
+        c.fd = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (connect(c.fd, (sockaddr*)&addr, sizeof(addr)) != 0) failures++;
+        c.name = "load" + to_string(firstSession + i);
+    }
+
+    string reply;
+    for (int i = 0; i < sessions; ++i) {
+        LoadConnection& c = connections[i];
+        c.sendLine("register|" + c.name + "|pass123\nlogin|" + c.name + "|pass123\n");
+        for (int j = 0; j < 2; ++j)
+            if (!c.readReply(reply) || reply != "OK") failures++;
+    }
+
+    mt19937 rng(firstSession);
+    const char* words[] = {"leather", "jacket", "laptop", "book", "car", "phone"};
+    vector<string> requests(sessions);
+    vector<BenchClock::time_point> sentAt(sessions);
+    for (int round = 0; round < rounds; ++round) {
+        for (int step = 0; step < 3; ++step) {
+            for (int i = 0; i < sessions; ++i) {
+                LoadConnection& c = connections[i];
+                if (step == 0) requests[i] = string("search|") + words[rng() % 6] + "\n";
+                else if (step == 1) requests[i] = "add|" + c.name + "|" + to_string(1 + rng() % 80) + "|1\n";
+                else requests[i] = "checkout|" + c.name + "|cod|normal|House " + c.name + ", Lahore\n";
+                sentAt[i] = BenchClock::now();
+                if (!c.sendLine(requests[i])) failures++;
+            }
+            for (int i = 0; i < sessions; ++i) {
+                if (!connections[i].readReply(reply) || reply.compare(0, 2, "OK") != 0) failures++;
+                latenciesNs.push_back(elapsedNs(sentAt[i]));
+            }
+        }
+    }
+    for (int i = 0; i < sessions; ++i) close(connections[i].fd);
+}
+
+void benchServerLoad() {
+    cout << "\n--- server mode: local load test ---" << endl;
+    cout << setw(10) << "sessions" << setw(10) << "workers" << setw(12) << "requests" << setw(14) << "requests/s"
+         << setw(10) << "p50 us" << setw(10) << "p99 us" << setw(12) << "p99.9 us" << setw(10) << "check" << endl;
+
+    const int clientThreads = 4;
+    const int workers = max(2u, thread::hardware_concurrency());
+    for (int sessions = 100; sessions <= 4000; sessions *= (sessions == 100 ? 10 : 4)) {
+        BenchDir dir;
+        int rounds = max(2, 30000 / (sessions * 3));
+        vector<double> latencies[clientThreads];
+        int failures[clientThreads] = {};
+        double seconds = 0.0;
+        int orders = 0;
+        {
+            QuietCout quiet;
+            NTSHOP shop;
+            ShopServer server(&shop, workers);
+            int port = server.listenOn(0);
+            thread serving(&ShopServer::run, &server, (const volatile sig_atomic_t*)NULL);
+
+            vector<thread> clients;
+            BenchClock::time_point start = BenchClock::now();
+            for (int t = 0; t < clientThreads; ++t) {
+                int share = sessions / clientThreads;
+                clients.emplace_back(runLoadClient, port, t * share, share, rounds, ref(latencies[t]), ref(failures[t]));
+            }
+            for (int t = 0; t < clientThreads; ++t) clients[t].join();
+            seconds = elapsedNs(start) / 1e9;
+            server.stop();
+            serving.join();
+            orders = shop.getOrderCount();
+        }
+
+        vector<double> all;
+        int failed = 0;
+        for (int t = 0; t < clientThreads; ++t) {
+            all.insert(all.end(), latencies[t].begin(), latencies[t].end());
+            failed += failures[t];
+        }
+        sort(all.begin(), all.end());
+        bool ok = failed == 0 && !all.empty() && orders == sessions * rounds;
+        // Setup requests are not in the latency table but are in the rate
+        size_t requests = all.size() + (size_t)sessions * 2;
+        cout << setw(10) << sessions << setw(10) << workers << setw(12) << requests << setw(14) << fixed
+             << setprecision(0) << requests / seconds << setprecision(1) << setw(10) << all[all.size() / 2] / 1000
+             << setw(10) << all[all.size() * 99 / 100] / 1000 << setw(12) << all[all.size() * 999 / 1000] / 1000
+             << setw(10) << (ok ? "ok" : "MISMATCH") << endl;
+    }
+}
+
+// ========== CONCURRENT CHECKOUTS ==========
+// Stress test of NTSHOP from several threads. Each thread has its own
+// customers and keeps filling a cart and checking out, with a catalog lookup,
+// a product search and a user lookup between checkouts. The check is that
+// every checkout got its own order ID, every order is filed under its
+// customer, and a shop reopened from disk has them all.
+static void runCheckoutThread(NTSHOP* shop, int thread, int customers, int checkouts, vector<int>* ids,
+                              size_t* seen) {
+    mt19937 rng(thread);
+    const char* words[] = {"leather", "laptop", "book", "phone"};
+    for (int i = 0; i < checkouts; ++i) {
+        string name = "t" + to_string(thread) + "c" + to_string(i % customers);
+        Customer* c = shop->findCustomer(name);
+        *seen += shop->getProductById(1 + rng() % 80) != NULL;
+        *seen += shop->searchProducts(words[rng() % 4]).size();
+        lock_guard<mutex> lock(shop->customerLock(name));
+        for (int j = 0; j < 3; ++j) c->addToCart(shop->getProductById(1 + rng() % 80), 1 + j);
+        ids->push_back(c->placeCartOrder("House " + to_string(i % customers) + ", Lahore", PAYMENT_COD, DELIVERY_NORMAL));
+    }
+}
+
+void benchConcurrentCheckouts() {
+    cout << "\n--- concurrent checkouts (" << thread::hardware_concurrency() << " hardware threads) ---" << endl;
+    cout << setw(10) << "threads" << setw(12) << "orders" << setw(14) << "orders/s" << setw(10) << "speedup"
+         << setw(10) << "check" << endl;
+
+    const int customersPerThread = 50, checkoutsPerThread = 20000;
+    double singleRate = 0.0;
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        BenchDir dir;
+        double rate = 0.0;
+        bool ok = true;
+        {
+            QuietCout quiet;
+            NTSHOP* shop = new NTSHOP();
+            for (int t = 0; t < threads; ++t)
+                for (int c = 0; c < customersPerThread; ++c) shop->registerCustomer("t" + to_string(t) + "c" + to_string(c), "pass123");
+
+            vector<vector<int> > ids(threads);
+            vector<size_t> seen(threads, 0);
+            vector<std::thread> workers;
+            BenchClock::time_point start = BenchClock::now();
+            for (int t = 0; t < threads; ++t)
+                workers.emplace_back(runCheckoutThread, shop, t, customersPerThread, checkoutsPerThread, &ids[t], &seen[t]);
+            for (int t = 0; t < threads; ++t) workers[t].join();
+            rate = (double)threads * checkoutsPerThread / (elapsedNs(start) / 1e9);
+
+            vector<int> all;
+            for (int t = 0; t < threads; ++t) {
+                benchSink += seen[t];
+                all.insert(all.end(), ids[t].begin(), ids[t].end());
+            }
+            sort(all.begin(), all.end());
+            ok = all.front() > 0 && adjacent_find(all.begin(), all.end()) == all.end();
+            for (int t = 0; t < threads && ok; ++t)
+                for (int c = 0; c < customersPerThread; ++c)
+                    ok = ok && shop->getOrderSlotsOf("t" + to_string(t) + "c" + to_string(c)).size() ==
+                               (size_t)(checkoutsPerThread / customersPerThread);
+            int orders = shop->getOrderCount();
+            ok = ok && orders == threads * checkoutsPerThread;
+            delete shop;
+
+            shop = new NTSHOP();
+            ok = ok && shop->getOrderCount() == orders;
+            delete shop;
+        }
+        if (threads == 1) singleRate = rate;
+        cout << setw(10) << threads << setw(12) << threads * checkoutsPerThread << setw(14) << fixed << setprecision(0)
+             << rate << setw(10) << setprecision(2) << rate / singleRate << setw(10) << (ok ? "ok" : "MISMATCH") << endl;
+    }
+}
+
+// ========== PARALLEL LOADING ==========
+// Opens a shop from its text files alone with 1, 2, 4, ... loader threads.
+// The orders file is written directly and is about 2 GB at the largest size.
+// Each load runs in a child process that exits without the destructor's save,
+// which would rewrite every file. The check is that every thread count loads
+// the same users and the same orders in the same order.
+struct LoadResult {
+    double ms;
+    int users;
+    int orders;
+    long long checksum;  // sum of (slot + 1) * ID over the orders
+};
+
+// Writes users.txt with customers cust0.. and orders.txt with n orders for
+// them, straight to disk. With repeatEvery > 0, every repeatEvery-th line
+// repeats the ID of the line repeatEvery / 2 before it as a cancelled order;
+// no other order is cancelled. Returns the size of orders.txt in MB.
+static double writeShopFiles(int n, int customers, int repeatEvery = 0) {
+    {
+        ofstream users(USERS_FILE);
+        users << "ADMIN|admin|admin123|\n";
+        for (int c = 0; c < customers; ++c) users << "CUSTOMER|cust" << c << "|pass123|House " << c << "\n";
+    }
+    double mb = 0.0;
+    FILE* orders = fopen(ORDERS_FILE.c_str(), "wb");
+    char line[256];
+    for (int i = 0; i < n; ++i) {
+        int c = i % customers;
+        bool repeat = repeatEvery > 0 && i % repeatEvery == repeatEvery - 1;
+        int length = snprintf(line, sizeof(line),
+                              "%d|cust%d|House %d, Street %d, Gulberg III, Lahore, Punjab 54000|%d|%d|%s|%d|%s|%s\n",
+                              1001 + (repeat ? i - repeatEvery / 2 : i), c, c, c % 50, 1 + i % 3, 1000 * (1 + i % 97),
+                              DELIVERY_TYPE_NAMES[i % 4 == 0].c_str(), i % 4 ? 0 : 500,
+                              PAYMENT_METHOD_NAMES[i % 2].c_str(),
+                              ORDER_STATUS_NAMES[repeat ? STATUS_CANCELLED : (OrderStatus)(i % 5 == 0)].c_str());
+        fwrite(line, 1, (size_t)length, orders);
+        mb += length / 1e6;
+    }
+    fclose(orders);
+    return mb;
+}
+
+static LoadResult loadInChild(int workers) {
+    LoadResult result = {-1.0, 0, 0, 0};
+    int fds[2];
+    if (pipe(fds) != 0) return result;
+    pid_t child = fork();
+    if (child == 0) {
+        close(fds[0]);
+        cout.rdbuf(NULL);
+        BenchClock::time_point start = BenchClock::now();
+        NTSHOP* shop = new NTSHOP(workers);
+        result.ms = elapsedNs(start) / 1e6;
+        result.users = shop->getUserCount();
+        result.orders = shop->getOrderCount();
+        for (int i = 0; i < result.orders; ++i) result.checksum += (long long)(i + 1) * shop->getOrderAt(i).getId();
+        ssize_t written = write(fds[1], &result, sizeof(result));
+        _exit(written == (ssize_t)sizeof(result) ? 0 : 1);
+    }
+    close(fds[1]);
+    if (child < 0 || read(fds[0], &result, sizeof(result)) != (ssize_t)sizeof(result)) result.ms = -1.0;
+    close(fds[0]);
+    if (child > 0) waitpid(child, NULL, 0);
+    return result;
+}
+
+void benchParallelLoading() {
+    cout << "\n--- startup from text files: parallel chunked loading (" << thread::hardware_concurrency()
+         << " hardware threads) ---" << endl;
+    cout << setw(10) << "orders" << setw(10) << "MB" << setw(10) << "threads" << setw(12) << "load ms"
+         << setw(10) << "MB/s" << setw(10) << "speedup" << setw(10) << "check" << endl;
+
+    const int customers = 1000;
+    const int maxWorkers = (int)max(4u, thread::hardware_concurrency());
+    const int sizes[] = {1000000, 16000000};
+    for (int n : sizes) {
+        BenchDir dir;
+        double mb = writeShopFiles(n, customers);
+
+        LoadResult first = {0.0, 0, 0, 0};
+        for (int workers = 1; workers <= maxWorkers; workers *= 2) {
+            LoadResult r = loadInChild(workers);
+            if (workers == 1) first = r;
+            bool ok = r.ms >= 0 && r.users == customers + 1 && r.orders == n && r.checksum == first.checksum;
+            cout << setw(10) << n << setw(10) << fixed << setprecision(0) << mb << setw(10) << workers
+                 << setw(12) << setprecision(1) << r.ms << setw(10) << setprecision(0) << mb / (r.ms / 1000)
+                 << setw(10) << setprecision(2) << first.ms / r.ms << setw(10) << (ok ? "ok" : "MISMATCH") << endl;
+        }
+    }
+}
+
+// ========== ORDER ID INDEX ==========
+// Loads orders.txt at 10^5 and 10^6 orders, 1% of the lines repeating an
+// earlier ID, then looks up and updates orders by ID. Before the order ID
+// index the load rescanned every order per line and took hours at 10^6. The
+// check is that ten times the orders load in under twenty times the time,
+// that each repeated ID kept its first order, and that every order is found.
+void benchOrderIdIndex() {
+    cout << "\n--- order ID index: text load and lookups ---" << endl;
+    cout << setw(10) << "lines" << setw(12) << "load ms" << setw(14) << "load ns/line" << setw(18) << "findOrderSlot ns"
+         << setw(14) << "change ns" << setw(10) << "check" << endl;
+
+    double previousNsPerLine = 0.0;
+    for (int n = 100000; n <= 1000000; n *= 10) {
+        BenchDir dir;
+        writeShopFiles(n, 1000, 100);
+        int expected = n - n / 100;
+        double loadMs, findNs, changeNs;
+        bool ok;
+        {
+            QuietCout quiet;
+            BenchClock::time_point start = BenchClock::now();
+            NTSHOP* shop = new NTSHOP(1);
+            loadMs = elapsedNs(start) / 1e6;
+            ok = shop->getOrderCount() == expected && shop->countOrdersWithStatus(STATUS_CANCELLED) == 0;
+
+            vector<int> ids;
+            for (int i = 0; i < n; ++i)
+                if (i % 100 != 99) ids.push_back(1001 + i);
+            shuffle(ids.begin(), ids.end(), mt19937(22));
+            int found = 0;
+            start = BenchClock::now();
+            for (size_t i = 0; i < ids.size(); ++i) found += shop->getOrderAt(shop->findOrderSlot(ids[i])).getId() == ids[i];
+            findNs = elapsedNs(start) / ids.size();
+            ok = ok && found == expected && shop->findOrderSlot(1001 + n) < 0;
+
+            const int changes = 100000;
+            int changed = 0;
+            start = BenchClock::now();
+            for (int i = 0; i < changes; ++i) changed += shop->changeOrderStatus(ids[i], STATUS_PLACED, STATUS_CANCELLED);
+            changeNs = elapsedNs(start) / changes;
+            ok = ok && changed == shop->countOrdersWithStatus(STATUS_CANCELLED) && changed > 0;
+            delete shop;
+        }
+        double nsPerLine = loadMs * 1e6 / n;
+        if (previousNsPerLine > 0.0) ok = ok && nsPerLine < 2 * previousNsPerLine;
+        previousNsPerLine = nsPerLine;
+        cout << setw(10) << n << setw(12) << fixed << setprecision(1) << loadMs << setw(14) << nsPerLine
+             << setw(18) << findNs << setw(14) << changeNs << setw(10) << (ok ? "ok" : "MISMATCH") << endl;
+    }
+}
+
+// ========== CUSTOMER TOTALS ==========
+// Places orders for 10^4 customers, cancels and delivers some of them, then
+// compares the totals NTSHOP keeps per customer with a scan of each
+// customer's orders, which is what Admin::searchCustomer did before. The
+// check is that both agree for every customer, including after reopening
+// the shop from its snapshot and from its text files, and that the top
+// customers report matches a full sort of the scanned totals.
+static CustomerTotals scanCustomerTotals(const NTSHOP& shop, const string& uname) {
+    CustomerTotals totals;
+    const vector<int>& mine = shop.getOrderSlotsOf(uname);
+    for (size_t j = 0; j < mine.size(); ++j) {
+        const Order& o = shop.getOrderAt(mine[j]);
+        totals.lastOrderId = o.getId();
+        if (o.getStatus() == STATUS_CANCELLED) continue;
+        totals.orders++;
+        totals.spent += o.getTotalCost();
+    }
+    return totals;
+}
+
+static bool totalsMatch(const NTSHOP& shop, const vector<string>& names) {
+    for (size_t i = 0; i < names.size(); ++i) {
+        CustomerTotals kept = shop.getCustomerTotals(names[i]), scanned = scanCustomerTotals(shop, names[i]);
+        if (kept.orders != scanned.orders || kept.lastOrderId != scanned.lastOrderId ||
+            fabs(kept.spent - scanned.spent) > 1e-6 * max(1.0, scanned.spent)) return false;
+    }
+    return true;
+}
+
+void benchCustomerTotals() {
+    cout << "\n--- customer totals: kept up to date vs scanned ---" << endl;
+    cout << setw(10) << "orders" << setw(14) << "scan ns/op" << setw(14) << "kept ns/op" << setw(12) << "top-10 ms"
+         << setw(10) << "check" << endl;
+
+    const int customers = 10000;
+    vector<string> names(customers);
+    for (int c = 0; c < customers; ++c) names[c] = "cust" + to_string(c);
+    mt19937 rng(23);
+    for (int n = 100000; n <= 1000000; n *= 10) {
+        BenchDir dir;
+        double scanNs, keptNs, topMs;
+        bool ok;
+        {
+            QuietCout quiet;
+            NTSHOP* shop = new NTSHOP();
+            for (int c = 0; c < customers; ++c) shop->registerCustomer(names[c], "pass123");
+            int firstId = Order::getNextOrderId();
+            for (int i = 0; i < n; ++i) {
+                CartItem cart[1] = { CartItem(shop->getProductById(1 + rng() % 80), 1 + rng() % 3) };
+                shop->placeOrder(names[rng() % customers], "House 1 Street 2", cart, 1, PAYMENT_COD, DELIVERY_NORMAL,
+                                 cart[0].getProduct()->calculatePrice(cart[0].getQuantity()));
+            }
+            for (int i = 0; i < n / 10; ++i) shop->changeOrderStatus(firstId + rng() % n, STATUS_PLACED, STATUS_CANCELLED);
+            for (int i = 0; i < n / 10; ++i) shop->changeOrderStatus(firstId + rng() % n, STATUS_PLACED, STATUS_DELIVERED);
+            ok = totalsMatch(*shop, names);
+
+            const int lookups = 100000;
+            double sum = 0.0;
+            BenchClock::time_point start = BenchClock::now();
+            for (int i = 0; i < lookups; ++i) sum += scanCustomerTotals(*shop, names[i % customers]).spent;
+            scanNs = elapsedNs(start) / lookups;
+            start = BenchClock::now();
+            for (int i = 0; i < lookups; ++i) sum -= shop->getCustomerTotals(names[i % customers]).spent;
+            keptNs = elapsedNs(start) / lookups;
+            benchSink += (long long)sum;
+
+            start = BenchClock::now();
+            vector<int> top = shop->topCustomers(10);
+            topMs = elapsedNs(start) / 1e6;
+            vector<pair<double, int> > ranked;
+            for (int c = 0; c < customers; ++c) ranked.push_back(make_pair(-scanCustomerTotals(*shop, names[c]).spent, c));
+            sort(ranked.begin(), ranked.end());
+            ok = ok && top.size() == 10;
+            for (size_t i = 0; i < top.size() && ok; ++i)
+                ok = shop->getUserAt(top[i])->getUsername() == names[ranked[i].second];
+            delete shop;
+
+            shop = new NTSHOP();
+            ok = ok && totalsMatch(*shop, names);
+            delete shop;
+            remove(SNAPSHOT_FILE.c_str());
+            shop = new NTSHOP();
+            ok = ok && totalsMatch(*shop, names);
+            delete shop;
+        }
+        cout << setw(10) << n << setw(14) << fixed << setprecision(1) << scanNs << setw(14) << keptNs
+             << setw(12) << setprecision(3) << topMs << setw(10) << (ok ? "ok" : "MISMATCH") << endl;
+    }
+}
+
+// ========== SALES REPORTS ==========
+// Opens shops of 10^6 and 10^7 orders from their text files, with one or two
+// line items per order and one order in ten then cancelled. Each sales report
+// is summed over the sales columns with 1, 2, 4, ... threads, and once order
+// by order over the Order objects and their lines, as a report without the
+// columns would. The check is that both give the same totals.
+enum SalesReportKind { REPORT_CATEGORY, REPORT_PAYMENT, REPORT_DELIVERY, REPORT_STATUS };
+const char* SALES_REPORT_NAMES[] = {"category", "payment", "delivery", "status"};
+
+static vector<SalesRow> salesReport(const NTSHOP& shop, int kind, int workers) {
+    if (kind == REPORT_CATEGORY) return shop.salesByCategory(workers);
+    if (kind == REPORT_PAYMENT) return shop.salesByPaymentMethod(workers);
+    if (kind == REPORT_DELIVERY) return shop.salesByDeliveryType(workers);
+    return shop.salesByStatus(workers);
+}
+
+static vector<SalesRow> scanSalesReport(const NTSHOP& shop, int kind) {
+    const int groups[] = {NUM_SALES_CATEGORIES, NUM_PAYMENT_METHODS, NUM_DELIVERY_TYPES, NUM_ORDER_STATUSES};
+    vector<SalesRow> rows(groups[kind]);
+    int count = shop.getOrderCount();
+    for (int i = 0; i < count; ++i) {
+        const Order& o = shop.getOrderAt(i);
+        if (kind == REPORT_STATUS) {
+            rows[o.getStatus()].count++;
+            rows[o.getStatus()].revenue += o.getTotalCost();
+            continue;
+        }
+        if (o.getStatus() == STATUS_CANCELLED) continue;
+        if (kind == REPORT_CATEGORY) {
+            const OrderLine* lines = shop.linesOf(o);
+            for (uint32_t j = 0; j < o.getLineCount(); ++j) {
+                SalesRow& row = rows[lines[j].product ? lines[j].product->getCategory() : NUM_CATEGORIES];
+                row.count += lines[j].quantity;
+                row.revenue += lines[j].price;
+            }
+        } else {
+            SalesRow& row = rows[kind == REPORT_PAYMENT ? (int)o.getPaymentMethod() : (int)o.getDeliveryType()];
+            row.count++;
+            row.revenue += o.getTotalCost();
+        }
+    }
+    return rows;
+}
+
+static bool salesMatch(const vector<SalesRow>& a, const vector<SalesRow>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t g = 0; g < a.size(); ++g)
+        if (a[g].count != b[g].count || fabs(a[g].revenue - b[g].revenue) > 1e-9 * max(1.0, b[g].revenue)) return false;
+    return true;
+}
+
+// Writes order_items.dat for the n orders of writeShopFiles: one line for
+// even orders, two for odd ones. Every 50th order's first line is for a
+// product no longer in the catalog.
+static void writeOrderItems(int n) {
+    FILE* items = fopen(ORDER_ITEMS_FILE.c_str(), "wb");
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j <= i % 2; ++j) {
+            int quantity = 1 + (i + j) % 3;
+            OrderLineRecord r = { 1001 + i, i % 50 == 0 && j == 0 ? 999999 : 1 + (i + j) % 80, quantity, 0,
+                                  quantity * 100.0 * (1 + i % 7) };
+            fwrite(&r, sizeof(r), 1, items);
+        }
+    }
+    fclose(items);
+}
+
+void benchSalesReports() {
+    cout << "\n--- sales reports: columns vs order by order (" << thread::hardware_concurrency()
+         << " hardware threads) ---" << endl;
+    cout << setw(10) << "orders" << setw(10) << "report" << setw(10) << "threads" << setw(14) << "by order ms"
+         << setw(14) << "columns ms" << setw(10) << "speedup" << setw(10) << "check" << endl;
+
+    const int customers = 10000;
+    const int maxWorkers = (int)max(4u, thread::hardware_concurrency());
+    const int sizes[] = {1000000, 10000000};
+    for (int n : sizes) {
+        BenchDir dir;
+        NTSHOP* shop;
+        {
+            QuietCout quiet;
+            delete new NTSHOP();  // saves the default catalog to products.txt
+            remove(SNAPSHOT_FILE.c_str());
+            writeShopFiles(n, customers);
+            writeOrderItems(n);
+            shop = new NTSHOP();
+            for (int i = 3; i < n; i += 10) shop->changeOrderStatus(1001 + i, STATUS_PLACED, STATUS_CANCELLED);
+        }
+        for (int kind = REPORT_CATEGORY; kind <= REPORT_STATUS; ++kind) {
+            BenchClock::time_point start = BenchClock::now();
+            vector<SalesRow> scanned = scanSalesReport(*shop, kind);
+            double scanMs = elapsedNs(start) / 1e6;
+            for (int workers = 1; workers <= maxWorkers; workers *= 2) {
+                start = BenchClock::now();
+                vector<SalesRow> rows = salesReport(*shop, kind, workers);
+                double ms = elapsedNs(start) / 1e6;
+                cout << setw(10) << n << setw(10) << SALES_REPORT_NAMES[kind] << setw(10) << workers
+                     << setw(14) << fixed << setprecision(1) << scanMs << setw(14) << ms << setw(10)
+                     << setprecision(1) << scanMs / ms << setw(10) << (salesMatch(rows, scanned) ? "ok" : "MISMATCH")
+                     << endl;
+            }
+        }
+        {
+            QuietCout quiet;
+            delete shop;
+        }
+    }
+}
+
+// ========== GROUP COMMIT ==========
+// Checkouts from many threads, each acknowledged only once it is on disk,
+// for a range of commit delays. Orders per sync is how many checkouts shared
+// one journal write and sync; ack latency is how long placeCartOrder took.
+// The first row is a single buyer, which needs one sync per order. The check
+// is that a shop reopened from disk has every acknowledged order.
+static void runDurableCheckouts(NTSHOP* shop, int thread, int checkouts, vector<double>* latencies) {
+    string name = "buyer" + to_string(thread);
+    Customer* c = shop->findCustomer(name);
+    lock_guard<mutex> lock(shop->customerLock(name));  // each thread is its own customer
+    for (int i = 0; i < checkouts; ++i) {
+        c->addToCart(shop->getProductById(1 + (thread + i) % 80), 1);
+        BenchClock::time_point start = BenchClock::now();
+        c->placeCartOrder("House " + to_string(thread) + ", Lahore", PAYMENT_COD, DELIVERY_NORMAL);
+        latencies->push_back(elapsedNs(start) / 1000.0);
+    }
+}
+
+void benchGroupCommit() {
+    cout << "\n--- group commit: durable checkouts vs commit delay ---" << endl;
+    cout << setw(10) << "threads" << setw(10) << "delay us" << setw(12) << "orders/s" << setw(14) << "orders/sync"
+         << setw(12) << "p50 ack us" << setw(12) << "p99 ack us" << setw(10) << "check" << endl;
+
+    const int delays[] = {-1, 0, 100, 500, 1000, 2000, 5000};  // -1: the single buyer
+    const int checkoutsPerThread = 400;
+    for (int delay : delays) {
+        int threads = delay < 0 ? 1 : 16;
+        BenchDir dir;
+        vector<vector<double> > latencies(threads);
+        double seconds = 0.0;
+        long long syncs = 0;
+        bool ok;
+        {
+            QuietCout quiet;
+            NTSHOP* shop = new NTSHOP();
+            shop->setCommitDelay(max(0, delay));
+            for (int t = 0; t < threads; ++t) shop->registerCustomer("buyer" + to_string(t), "pass123");
+            shop->commitJournal();
+            long long setupSyncs = shop->getJournalSyncCount();
+
+            vector<std::thread> workers;
+            BenchClock::time_point start = BenchClock::now();
+            for (int t = 0; t < threads; ++t)
+                workers.emplace_back(runDurableCheckouts, shop, t, checkoutsPerThread, &latencies[t]);
+            for (int t = 0; t < threads; ++t) workers[t].join();
+            seconds = elapsedNs(start) / 1e9;
+            syncs = shop->getJournalSyncCount() - setupSyncs;
+            ok = shop->getOrderCount() == threads * checkoutsPerThread;
+            delete shop;
+
+            shop = new NTSHOP();
+            ok = ok && shop->getOrderCount() == threads * checkoutsPerThread;
+            delete shop;
+        }
+
+        vector<double> all;
+        for (int t = 0; t < threads; ++t) all.insert(all.end(), latencies[t].begin(), latencies[t].end());
+        sort(all.begin(), all.end());
+        cout << setw(10) << threads << setw(10) << max(0, delay) << setw(12) << fixed << setprecision(0)
+             << all.size() / seconds << setw(14) << setprecision(1) << (double)all.size() / max(1LL, syncs)
+             << setw(12) << all[all.size() / 2] << setw(12) << all[all.size() * 99 / 100]
+             << setw(10) << (ok ? "ok" : "MISMATCH") << endl;
+    }
+}
+
+// ========== CORE OPERATIONS ==========
+// The NTSHOP operations a session spends its time in, on synthetic shops of
+// n products, n customers and n orders. Each result is also kept in
+// benchResults so it can be written out as CSV or JSON.
+struct BenchResult {
+    string operation;
+    int records;
+    long long iterations;
+    double nsPerOp;
+    bool ok;
+};
+
+static vector<BenchResult> benchResults;
+static vector<int> coreSizes = {1000, 10000, 100000, 1000000};
+
+static void reportCore(const string& operation, int records, long long iterations, double totalNs, bool ok) {
+    BenchResult r = {operation, records, iterations, totalNs / iterations, ok};
+    benchResults.push_back(r);
+    cout << setw(24) << operation << setw(10) << records << setw(16) << fixed << setprecision(1) << r.nsPerOp
+         << setw(16) << setprecision(0) << 1e9 / r.nsPerOp << setw(10) << (ok ? "ok" : "MISMATCH") << endl;
+}
+
+void benchCoreOperations() {
+    cout << "\n--- core NTSHOP operations on synthetic shops ---" << endl;
+    cout << setw(24) << "operation" << setw(10) << "records" << setw(16) << "ns/op"
+         << setw(16) << "ops/s" << setw(10) << "check" << endl;
+
+    for (size_t s = 0; s < coreSizes.size(); ++s) {
+        int n = coreSizes[s];
+        BenchDir dir;
+        mt19937 rng(17 + n);
+        int users = 0, products = 0, orders = 0;
+        {
+            NTSHOP* shop;
+            {
+                QuietCout quiet;
+                shop = new NTSHOP();
+            }
+            vector<string> names(n);
+            for (int i = 0; i < n; ++i) {
+                names[i] = "cust" + to_string(i);
+                shop->addProduct(NTSHOP::createProduct(rng() % 4, 1000 + i, "Item " + to_string(i),
+                                                       100.0 + (rng() % 1000000) / 100.0, "General"));
+                Customer* c = new Customer(names[i], "pass123", shop);
+                shop->addUser(c);
+                shop->updateCustomerAddress(c, "House " + to_string(i) + " Street " + to_string(i % 97) + ", Lahore");
+            }
+            {
+                QuietCout quiet;
+                CartItem cart[2] = { CartItem(shop->getProductById(62), 1), CartItem(shop->getProductById(1000), 2) };
+                for (int i = 0; i < n; ++i)
+                    shop->placeOrder(names[i], "House " + to_string(i) + " Street 2, Lahore", cart, 2,
+                                     PAYMENT_COD, DELIVERY_NORMAL, 100000.0);
+            }
+
+            const int lookups = 1000000;
+            vector<int> keys(lookups);
+            for (int i = 0; i < lookups; ++i) keys[i] = 1000 + rng() % n;
+            BenchClock::time_point start = BenchClock::now();
+            int found = 0;
+            for (int i = 0; i < lookups; ++i) found += shop->getProductById(keys[i]) != NULL;
+            reportCore("getProductById", n, lookups, elapsedNs(start), found == lookups);
+
+            vector<const string*> who(lookups);
+            for (int i = 0; i < lookups; ++i) who[i] = &names[rng() % n];
+            start = BenchClock::now();
+            found = 0;
+            for (int i = 0; i < lookups; ++i) found += shop->findUser(*who[i]) != NULL;
+            reportCore("findUser", n, lookups, elapsedNs(start), found == lookups);
+
+            // A full cart of random products
+            Customer* buyer = shop->findCustomer(names[0]);
+            double expected = 0.0;
+            for (int i = 0; i < MAX_CART_ITEMS; ++i) {
+                Product* p = shop->getProductById(1000 + rng() % n);
+                int quantity = 1 + rng() % 5;
+                buyer->addToCart(p, quantity);
+                expected += p->calculatePrice(quantity);
+            }
+            const int totals = 1000000;
+            double sum = 0.0;
+            start = BenchClock::now();
+            for (int i = 0; i < totals; ++i) sum += buyer->calculateCartTotal();
+            reportCore("calculateCartTotal", n, totals, elapsedNs(start), fabs(sum / totals - expected) < 1e-6 * expected);
+            buyer->clearCart();
+
+            // Fill a three-line cart and check out, as a session would
+            const int checkouts = 10000;
+            int placed = 0;
+            {
+                QuietCout quiet;
+                start = BenchClock::now();
+                for (int i = 0; i < checkouts; ++i) {
+                    Customer* c = shop->findCustomer(*who[i]);
+                    for (int j = 0; j < 3; ++j) c->addToCart(shop->getProductById(keys[i * 3 + j]), 1 + j);
+                    placed += c->placeCartOrder(c->getAddress(), PAYMENT_COD, DELIVERY_URGENT) > 0;
+                }
+            }
+            reportCore("checkout", n, checkouts, elapsedNs(start), placed == checkouts);
+
+            // What Admin::searchCustomer does for each search type
+            const int searches = 100000;
+            double spent = 0.0;
+            found = 0;
+            start = BenchClock::now();
+            for (int i = 0; i < searches; ++i) {
+                Customer* c = shop->findCustomer(*who[i]);
+                if (!c) continue;
+                found++;
+                spent += shop->getCustomerTotals(c->getUsername()).spent;
+            }
+            reportCore("searchCustomer username", n, searches, elapsedNs(start), found == searches);
+            benchSink += (long long)spent;
+
+            const int addressSearches = 10000;
+            found = 0;
+            start = BenchClock::now();
+            for (int i = 0; i < addressSearches; ++i) {
+                int c = rng() % n;
+                found += !shop->findCustomersByAddress("House " + to_string(c) + " Street " + to_string(c % 97)).empty();
+            }
+            reportCore("searchCustomer address", n, addressSearches, elapsedNs(start), found == addressSearches);
+
+            users = shop->getUserCount();
+            products = shop->getProductCount();
+            orders = shop->getOrderCount();
+            double saveNs;
+            {
+                QuietCout quiet;
+                start = BenchClock::now();
+                shop->saveData();
+                saveNs = elapsedNs(start);
+                delete shop;
+            }
+            reportCore("saveData", n, 1, saveNs, true);
+        }
+
+        // Only the constructor is timed, not the destructor's save
+        NTSHOP* shop;
+        BenchClock::time_point start = BenchClock::now();
+        {
+            QuietCout quiet;
+            shop = new NTSHOP();
+        }
+        double loadNs = elapsedNs(start);
+        bool ok = shop->getUserCount() == users && shop->getProductCount() == products && shop->getOrderCount() == orders;
+        {
+            QuietCout quiet;
+            delete shop;
+        }
+        reportCore("load snapshot", n, 1, loadNs, ok);
+
+        remove(SNAPSHOT_FILE.c_str());
+        start = BenchClock::now();
+        {
+            QuietCout quiet;
+            shop = new NTSHOP();
+        }
+        loadNs = elapsedNs(start);
+        ok = shop->getUserCount() == users && shop->getProductCount() == products && shop->getOrderCount() == orders;
+        {
+            QuietCout quiet;
+            delete shop;
+        }
+        reportCore("load text files", n, 1, loadNs, ok);
+    }
+}
+
+static bool writeResultsCsv(const string& path) {
+    ofstream out(path);
+    if (!out) return false;
+    out << "operation,records,iterations,ns_per_op,ok\n";
+    for (size_t i = 0; i < benchResults.size(); ++i) {
+        const BenchResult& r = benchResults[i];
+        out << r.operation << ',' << r.records << ',' << r.iterations << ','
+            << fixed << setprecision(2) << r.nsPerOp << ',' << (r.ok ? "true" : "false") << '\n';
+    }
+    return (bool)out;
+}
+
+static bool writeResultsJson(const string& path) {
+    ofstream out(path);
+    if (!out) return false;
+    out << "{\n  \"compiler\": \"" << __VERSION__ << "\",\n  \"results\": [";
+    for (size_t i = 0; i < benchResults.size(); ++i) {
+        const BenchResult& r = benchResults[i];
+        out << (i ? "," : "") << "\n    {\"operation\": \"" << r.operation << "\", \"records\": " << r.records
+            << ", \"iterations\": " << r.iterations << ", \"ns_per_op\": " << fixed << setprecision(2) << r.nsPerOp
+            << ", \"ok\": " << (r.ok ? "true" : "false") << "}";
+    }
+    out << "\n  ]\n}\n";
+    return (bool)out;
+}
+
+struct BenchSuite {
+    const char* name;
+    void (*run)();
+};
+
+const BenchSuite BENCH_SUITES[] = {
+    {"product-lookup", benchProductLookup},
+    {"user-lookup", benchUserLookup},
+    {"order-growth", benchOrderGrowth},
+    {"checkout-journal", benchCheckoutJournal},
+    {"startup", benchStartup},
+    {"text-parsing", benchTextParsing},
+    {"product-search", benchProductSearch},
+    {"address-search", benchAddressSearch},
+    {"category-index", benchCategoryIndex},
+    {"order-footprint", benchOrderFootprint},
+    {"batch-pricing", benchBatchPricing},
+    {"checkout-allocations", benchCheckoutAllocations},
+    {"listing-output", benchListingOutput},
+    {"batch-replay", benchBatchReplay},
+    {"server-load", benchServerLoad},
+    {"concurrent-checkouts", benchConcurrentCheckouts},
+    {"group-commit", benchGroupCommit},
+    {"parallel-loading", benchParallelLoading},
+    {"order-id-index", benchOrderIdIndex},
+    {"customer-totals", benchCustomerTotals},
+    {"sales-reports", benchSalesReports},
+    {"price-index", benchPriceIndex},
+    {"core", benchCoreOperations},
+};
+const int NUM_BENCH_SUITES = sizeof(BENCH_SUITES) / sizeof(BENCH_SUITES[0]);
+
+// Comma-separated list into its items
+static vector<string> splitList(const string& list) {
+    vector<string> items;
+    string_view fields[64];
+    int count = splitFields(list, ',', fields, 64);
+    for (int i = 0; i < count; ++i)
+        if (!fields[i].empty()) items.push_back(string(fields[i]));
+    return items;
+}
+
+int main(int argc, char* argv[]) {
+    vector<string> suites;
+    string csvPath, jsonPath;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (i + 1 == argc) {
+            cerr << "Missing value after " << arg << endl;
+            return 1;
+        }
+        string value = argv[++i];
+        if (arg == "--suite") {
+            suites = splitList(value);
+        } else if (arg == "--sizes") {
+            coreSizes.clear();
+            vector<string> sizes = splitList(value);
+            for (size_t j = 0; j < sizes.size(); ++j) {
+                int n;
+                if (!parseInt(sizes[j], n) || n < 1000) {
+                    cerr << "Invalid size " << sizes[j] << " (at least 1000)" << endl;
+                    return 1;
+                }
+                coreSizes.push_back(n);
+            }
+        } else if (arg == "--csv") {
+            csvPath = value;
+        } else if (arg == "--json") {
+            jsonPath = value;
+        } else {
+            cerr << "Unknown option " << arg << endl;
+            return 1;
+        }
+    }
+    for (size_t i = 0; i < suites.size(); ++i) {
+        int j = 0;
+        while (j < NUM_BENCH_SUITES && suites[i] != BENCH_SUITES[j].name) j++;
+        if (j == NUM_BENCH_SUITES) {
+            cerr << "Unknown suite " << suites[i] << ". Suites:";
+            for (int k = 0; k < NUM_BENCH_SUITES; ++k) cerr << ' ' << BENCH_SUITES[k].name;
+            cerr << endl;
+            return 1;
+        }
+    }
+
+    for (int i = 0; i < NUM_BENCH_SUITES; ++i)
+        if (suites.empty() || find(suites.begin(), suites.end(), BENCH_SUITES[i].name) != suites.end())
+            BENCH_SUITES[i].run();
+
+    // Paths are relative to where the program was started; BenchDir restores it
+    if (!csvPath.empty() && !writeResultsCsv(csvPath)) {
+        cerr << "Cannot write " << csvPath << endl;
+        return 1;
+    }
+    if (!jsonPath.empty() && !writeResultsJson(jsonPath)) {
+        cerr << "Cannot write " << jsonPath << endl;
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
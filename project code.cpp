@@ -3,20 +3,104 @@
 #include <string>
 #include <sstream>
 #include <cctype>
+#include <cstdlib>
 #include <fstream>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <unordered_map>
+#include <string_view>
+#include <charconv>
+#include <algorithm>
+#include <deque>
+#include <unordered_set>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <shared_mutex>
+#include <csignal>
+#include <filesystem>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fcntl.h>
+#include <io.h>
+#endif
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#define NTSHOP_SERVER 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define NTSHOP_SSE2 1
+#endif
 
 using namespace std;
 
-const int MAX_PRODUCTS = 100;  // Increased to accommodate more products
-const int MAX_USERS = 50;
-const int MAX_ORDERS = 200;
 const int MAX_CART_ITEMS = 20;
+const int MAX_SEARCH_RESULTS = 50;  // products listed per keyword search
 const int MAX_ORDER_ITEMS = 20;
+const int PRODUCTS_PER_PAGE = 25;  // rows per page of a product listing
+const int ORDERS_PER_PAGE = 10;    // orders per page of an order listing
+const int TOP_CUSTOMERS_SHOWN = 10;  // rows of the top customers report
+const int PRICE_EXTREMES_SHOWN = 5;  // products per category in the cheapest / most expensive listing
+const size_t SALES_SCAN_CHUNK = 1 << 16;  // rows one thread sums at a time in a sales report
 
 // File names for persistence
 const string USERS_FILE = "users.txt";
 const string PRODUCTS_FILE = "products.txt";
 const string ORDERS_FILE = "orders.txt";
+const string JOURNAL_FILE = "journal.txt";  // changes made since the last full save
+const string ORDER_ITEMS_FILE = "order_items.dat";  // fixed-size line item records of every order
+const string SNAPSHOT_FILE = "shop.snap";   // binary copy of all the files above, loaded first
+
+// The text files are parsed in newline-aligned chunks of about this size,
+// one chunk per loader thread at a time
+const size_t LOAD_CHUNK_BYTES = 8 << 20;
+
+// The journal is folded into the data files once it holds at least this many
+// events and at least as many events as there are records already saved, so
+// each full rewrite is paid for by the appends that came before it
+const int JOURNAL_CHECKPOINT_EVENTS = 1000;
+
+// Journal changes reach the disk in batches. The first change of a batch
+// waits this many microseconds for others to join it; 0 syncs right away
+// with whatever changes are already waiting.
+const int DEFAULT_COMMIT_DELAY_US = 0;
+
+// Customers' carts are guarded by this many mutexes, picked by username hash
+const int CUSTOMER_LOCK_SHARDS = 64;
+
+// Product categories, in the order menus and summaries list them
+enum Category : uint8_t { CATEGORY_FASHION, CATEGORY_EDUCATION, CATEGORY_AUTOMOBILES, CATEGORY_ELECTRONICS };
+const string CATEGORY_NAMES[] = { "Fashion", "Education", "Automobiles", "Electronics" };
+const int NUM_CATEGORIES = 4;
+
+// Order fields held as one-byte codes in memory. The name arrays give the
+// text written to the data files and shown on screen, indexed by code.
+enum OrderStatus : uint8_t { STATUS_PLACED, STATUS_DELIVERED, STATUS_CANCELLED };
+const string ORDER_STATUS_NAMES[] = { "Placed", "Delivered", "Cancelled" };
+const int NUM_ORDER_STATUSES = 3;
+
+enum DeliveryType : uint8_t { DELIVERY_NORMAL, DELIVERY_URGENT };
+const string DELIVERY_TYPE_NAMES[] = { "Normal", "Urgent" };
+const int NUM_DELIVERY_TYPES = 2;
+
+enum PaymentMethod : uint8_t { PAYMENT_ADVANCE, PAYMENT_COD };
+const string PAYMENT_METHOD_NAMES[] = { "Advance Payment", "Cash on Delivery (COD)" };
+const int NUM_PAYMENT_METHODS = 2;
 
 // Validation constants
 const int MIN_USERNAME_LENGTH = 3;
@@ -25,20 +109,239 @@ const int MIN_PASSWORD_LENGTH = 6;
 const int MAX_PASSWORD_LENGTH = 20;
 const int ACCOUNT_NUMBER_LENGTH = 16;  // Standard bank account number length
 
+// ========== TEXT FILE PARSING ==========
+// Reads a file in large chunks and hands out one line at a time as a view
+// into its buffer. Lines may be any length; the buffer grows to fit them.
+class LineReader {
+    FILE* file;
+    vector<char> buffer;
+    size_t begin, end;  // unread bytes are buffer[begin, end)
+    bool atEof;
+    long long bytes;
+
+public:
+    explicit LineReader(const string& path, size_t chunkSize = 1 << 20)
+        : file(fopen(path.c_str(), "rb")), buffer(chunkSize), begin(0), end(0), atEof(false), bytes(0) {
+        if (file && fseek(file, 0, SEEK_END) == 0) {
+            bytes = ftell(file);
+            fseek(file, 0, SEEK_SET);
+        }
+    }
+    ~LineReader() { if (file) fclose(file); }
+
+    LineReader(const LineReader&) = delete;
+    LineReader& operator=(const LineReader&) = delete;
+
+    bool isOpen() const { return file != NULL; }
+    long long fileSize() const { return bytes; }
+
+    // The view stays valid until the next call. Returns false at end of file.
+    bool next(string_view& line) {
+        if (!file) return false;
+        while (true) {
+            const char* start = buffer.data() + begin;
+            const char* newline = (const char*)memchr(start, '\n', end - begin);
+            if (newline) {
+                size_t length = newline - start;
+                begin += length + 1;
+                if (length > 0 && start[length - 1] == '\r') length--;
+                line = string_view(start, length);
+                return true;
+            }
+            if (atEof) {
+                if (begin == end) return false;
+                size_t length = end - begin;
+                if (start[length - 1] == '\r') length--;
+                line = string_view(start, length);
+                begin = end;
+                return true;
+            }
+            // Keep the partial line and refill behind it
+            memmove(buffer.data(), start, end - begin);
+            end -= begin;
+            begin = 0;
+            if (end == buffer.size()) buffer.resize(buffer.size() * 2);
+            size_t got = fread(buffer.data() + end, 1, buffer.size() - end, file);
+            end += got;
+            if (got == 0) atEof = true;
+        }
+    }
+};
+
+// Takes the next line off the front of text, without its line ending.
+// Returns false once text is used up.
+bool takeLine(string_view& text, string_view& line) {
+    if (text.empty()) return false;
+    size_t newline = text.find('\n');
+    line = text.substr(0, newline);
+    text = newline == string_view::npos ? string_view() : text.substr(newline + 1);
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    return true;
+}
+
+// Cuts text into at most pieces parts of about equal size. Every part but the
+// last ends just after a newline, so no line is split between two parts.
+vector<string_view> splitAtLines(string_view text, size_t pieces) {
+    vector<string_view> parts;
+    size_t begin = 0;
+    for (size_t i = 1; i <= pieces && begin < text.size(); ++i) {
+        size_t end = text.size();
+        if (i < pieces) {
+            size_t newline = text.find('\n', max(begin, text.size() / pieces * i));
+            if (newline != string_view::npos) end = newline + 1;
+        }
+        parts.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+    return parts;
+}
+
+// Calls work(i) for every i in [0, count) on up to workers threads, this one
+// included, and returns once all of them are done
+template <class Work>
+void runInParallel(size_t count, int workers, Work work) {
+    atomic<size_t> next(0);
+    auto drain = [&]() {
+        for (size_t i = next++; i < count; i = next++) work(i);
+    };
+    vector<thread> helpers;
+    for (size_t t = 1; t < min((size_t)workers, count); ++t) helpers.emplace_back(drain);
+    drain();
+    for (size_t t = 0; t < helpers.size(); ++t) helpers[t].join();
+}
+
+// Splits line at each sep into at most maxFields views and returns how many
+// were found. Fields past maxFields are ignored; missing ones are left empty.
+int splitFields(string_view line, char sep, string_view fields[], int maxFields) {
+    int count = 0;
+    size_t pos = 0;
+    while (count < maxFields) {
+        size_t bar = line.find(sep, pos);
+        if (bar == string_view::npos) {
+            fields[count++] = line.substr(pos);
+            break;
+        }
+        fields[count++] = line.substr(pos, bar - pos);
+        pos = bar + 1;
+    }
+    return count;
+}
+
+bool parseInt(string_view text, int& value) {
+    from_chars_result r = from_chars(text.data(), text.data() + text.size(), value);
+    return r.ec == errc() && r.ptr == text.data() + text.size();
+}
+
+bool parseDouble(string_view text, double& value) {
+    from_chars_result r = from_chars(text.data(), text.data() + text.size(), value);
+    return r.ec == errc() && r.ptr == text.data() + text.size();
+}
+
+// Position of text in names[0, count), or -1 if it is not one of them
+int lookupName(string_view text, const string names[], int count) {
+    for (int i = 0; i < count; ++i)
+        if (text == names[i]) return i;
+    return -1;
+}
+
+// Waits until everything written to fd is on disk. Does nothing for -1.
+void syncDescriptor(int fd) {
+    if (fd < 0) return;
+#if defined(_WIN32)
+    _commit(fd);
+#elif defined(__linux__)
+    fdatasync(fd);
+#else
+    fsync(fd);
+#endif
+}
+
+// Waits until the file at path is on disk. Returns false if it cannot be opened.
+bool syncFile(const string& path) {
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+#else
+    int fd = _open(path.c_str(), _O_RDWR | _O_BINARY);  // _commit needs write access
+#endif
+    if (fd < 0) return false;
+    syncDescriptor(fd);
+#ifndef _WIN32
+    close(fd);
+#else
+    _close(fd);
+#endif
+    return true;
+}
+
+// Closes a temporary file written in place of path and, once it is complete
+// and on disk, renames it over path, so a crash leaves either the old file or
+// the new one. On failure the temporary file is removed and path is kept.
+bool replaceFile(ofstream& written, const string& tempFile, const string& path) {
+    written.close();
+    if (written && syncFile(tempFile) && rename(tempFile.c_str(), path.c_str()) == 0) return true;
+    remove(tempFile.c_str());
+    return false;
+}
+
+// ========== LISTING OUTPUT ==========
+// Collects the text of a listing and writes it out in one call, instead of
+// flushing the console after every line. The storage is kept between pages.
+// Doubles are amounts and always print with two decimals.
+class RenderBuffer {
+    string text;
+
+    template <class T>
+    RenderBuffer& appendNumber(T value) {
+        char digits[32];
+        to_chars_result r = to_chars(digits, digits + sizeof(digits), value);
+        text.append(digits, r.ptr);
+        return *this;
+    }
+
+public:
+    RenderBuffer& operator<<(const string& s) { text += s; return *this; }
+    RenderBuffer& operator<<(const char* s) { text += s; return *this; }
+    RenderBuffer& operator<<(char c) { text += c; return *this; }
+    RenderBuffer& operator<<(int value) { return appendNumber(value); }
+    RenderBuffer& operator<<(size_t value) { return appendNumber(value); }
+    RenderBuffer& operator<<(long long value) { return appendNumber(value); }
+    RenderBuffer& operator<<(double value) {
+        char digits[64];
+        to_chars_result r = to_chars(digits, digits + sizeof(digits), value, chars_format::fixed, 2);
+        text.append(digits, r.ptr);
+        return *this;
+    }
+
+    size_t size() const { return text.size(); }
+
+    // Writes everything collected so far and starts over
+    void flushTo(ostream& out) {
+        out.write(text.data(), (streamsize)text.size());
+        out.flush();
+        text.clear();
+    }
+};
+
+// How a product turns its base price and a quantity into a line total. Each
+// rule mirrors one calculatePrice override; the batch pricer switches on it.
+enum PricingRule : uint8_t { PRICING_PLAIN, PRICING_TAXED, PRICING_BULK_DISCOUNT };
+
 class Product {
 protected:
     int id;
     string name;
-    string category;
+    Category category;
+    PricingRule pricing;
     double pricePKR;
 
 public:
-    Product(int i = 0, const string& n = "", const string& cat = "", double p = 0.0)
-        : id(i), name(n), category(cat), pricePKR(p) {}
+    Product(int i, const string& n, Category cat, double p, PricingRule rule = PRICING_PLAIN)
+        : id(i), name(n), category(cat), pricing(rule), pricePKR(p) {}
 
     virtual ~Product() {}
 
-    virtual void displayDetails() const = 0;
+    // Appends the product's one-line listing entry
+    virtual void renderDetails(RenderBuffer& out) const = 0;
     virtual double calculatePrice(int quantity) const {
         return pricePKR * quantity;
     }
@@ -48,12 +351,14 @@ public:
 
     int getId() const { return id; }
     string getName() const { return name; }
-    string getCategory() const { return category; }
+    Category getCategory() const { return category; }
+    const string& getCategoryName() const { return CATEGORY_NAMES[category]; }
     double getBasePrice() const { return pricePKR; }
+    PricingRule getPricingRule() const { return pricing; }
     
     virtual string toFileString() const {
         stringstream ss;
-        ss << getType() << "|" << id << "|" << name << "|" << category << "|" 
+        ss << getType() << "|" << id << "|" << name << "|" << getCategoryName() << "|" 
            << pricePKR << "|" << getSubCategory();
         return ss.str();
     }
@@ -63,14 +368,14 @@ class FashionProduct : public Product {
     string subCategory;
 public:
     FashionProduct(int i = 0, const string& n = "", double p = 0.0, const string& sub = "")
-        : Product(i, n, "Fashion", p), subCategory(sub) {}
+        : Product(i, n, CATEGORY_FASHION, p), subCategory(sub) {}
     
     string getType() const override { return "FASHION"; }
     string getSubCategory() const override { return subCategory; }
     
-    void displayDetails() const override {
-        cout << "[ID: " << id << "] " << name << " | Category: " << category
-             << " (" << subCategory << ") | Price: PKR " << fixed << setprecision(2) << pricePKR << endl;
+    void renderDetails(RenderBuffer& out) const override {
+        out << "[ID: " << id << "] " << name << " | Category: " << getCategoryName()
+            << " (" << subCategory << ") | Price: PKR " << pricePKR << '\n';
     }
 };
 
@@ -78,14 +383,14 @@ class EducationProduct : public Product {
     string subCategory;
 public:
     EducationProduct(int i = 0, const string& n = "", double p = 0.0, const string& sub = "")
-        : Product(i, n, "Education", p), subCategory(sub) {}
+        : Product(i, n, CATEGORY_EDUCATION, p), subCategory(sub) {}
     
     string getType() const override { return "EDUCATION"; }
     string getSubCategory() const override { return subCategory; }
     
-    void displayDetails() const override {
-        cout << "[ID: " << id << "] " << name << " | Category: " << category
-             << " (" << subCategory << ") | Price: PKR " << fixed << setprecision(2) << pricePKR << endl;
+    void renderDetails(RenderBuffer& out) const override {
+        out << "[ID: " << id << "] " << name << " | Category: " << getCategoryName()
+            << " (" << subCategory << ") | Price: PKR " << pricePKR << '\n';
     }
 };
 
@@ -93,14 +398,14 @@ class AutomobileProduct : public Product {
     string subCategory;
 public:
     AutomobileProduct(int i = 0, const string& n = "", double p = 0.0, const string& sub = "")
-        : Product(i, n, "Automobiles", p), subCategory(sub) {}
+        : Product(i, n, CATEGORY_AUTOMOBILES, p, PRICING_TAXED), subCategory(sub) {}
     
     string getType() const override { return "AUTOMOBILE"; }
     string getSubCategory() const override { return subCategory; }
     
-    void displayDetails() const override {
-        cout << "[ID: " << id << "] " << name << " | Category: " << category
-             << " (" << subCategory << ") | Price: PKR " << fixed << setprecision(2) << pricePKR << endl;
+    void renderDetails(RenderBuffer& out) const override {
+        out << "[ID: " << id << "] " << name << " | Category: " << getCategoryName()
+            << " (" << subCategory << ") | Price: PKR " << pricePKR << '\n';
     }
     
     double calculatePrice(int quantity) const override {
@@ -113,14 +418,14 @@ class ElectronicsProduct : public Product {
     string subCategory;
 public:
     ElectronicsProduct(int i = 0, const string& n = "", double p = 0.0, const string& sub = "")
-        : Product(i, n, "Electronics", p), subCategory(sub) {}
+        : Product(i, n, CATEGORY_ELECTRONICS, p, PRICING_BULK_DISCOUNT), subCategory(sub) {}
     
     string getType() const override { return "ELECTRONICS"; }
     string getSubCategory() const override { return subCategory; }
     
-    void displayDetails() const override {
-        cout << "[ID: " << id << "] " << name << " | Category: " << category
-             << " (" << subCategory << ") | Price: PKR " << fixed << setprecision(2) << pricePKR << endl;
+    void renderDetails(RenderBuffer& out) const override {
+        out << "[ID: " << id << "] " << name << " | Category: " << getCategoryName()
+            << " (" << subCategory << ") | Price: PKR " << pricePKR << '\n';
     }
     
     double calculatePrice(int quantity) const override {
@@ -149,54 +454,205 @@ public:
     bool isEmpty() const { return product == NULL || quantity <= 0; }
 };
 
+// ========== BATCH PRICING ==========
+// Line totals for n lines: out[i] is quantity[i] units at basePrice[i] under
+// rule[i]. Every rule is computed and the matching one selected, two lines
+// per step with SSE2 where it exists. The arithmetic is exactly that of the
+// calculatePrice overrides, so the results are identical to calling them.
+inline void priceLines(const double* basePrice, const int32_t* rule, const int32_t* quantity,
+                       double* out, size_t n) {
+    size_t i = 0;
+#ifdef NTSHOP_SSE2
+    const __m128d taxRate = _mm_set1_pd(0.05), discount = _mm_set1_pd(0.90);
+    const __m128i taxed32 = _mm_set1_epi32(PRICING_TAXED), bulk32 = _mm_set1_epi32(PRICING_BULK_DISCOUNT);
+    const __m128i two = _mm_set1_epi32(2);
+    for (; i + 2 <= n; i += 2) {
+        __m128i r = _mm_loadl_epi64((const __m128i*)(rule + i));
+        __m128i q = _mm_loadl_epi64((const __m128i*)(quantity + i));
+        __m128d base = _mm_mul_pd(_mm_loadu_pd(basePrice + i), _mm_cvtepi32_pd(q));
+        __m128d taxed = _mm_add_pd(base, _mm_mul_pd(base, taxRate));
+        __m128d discounted = _mm_mul_pd(base, discount);
+        // Widen the 32-bit lane masks to the 64-bit lanes of the prices
+        __m128i isTaxed = _mm_cmpeq_epi32(r, taxed32);
+        __m128i isBulk = _mm_and_si128(_mm_cmpeq_epi32(r, bulk32), _mm_cmpgt_epi32(q, two));
+        __m128d taxMask = _mm_castsi128_pd(_mm_unpacklo_epi32(isTaxed, isTaxed));
+        __m128d bulkMask = _mm_castsi128_pd(_mm_unpacklo_epi32(isBulk, isBulk));
+        __m128d price = _mm_or_pd(_mm_and_pd(taxMask, taxed), _mm_andnot_pd(taxMask, base));
+        price = _mm_or_pd(_mm_and_pd(bulkMask, discounted), _mm_andnot_pd(bulkMask, price));
+        _mm_storeu_pd(out + i, price);
+    }
+#endif
+    for (; i < n; ++i) {
+        double base = basePrice[i] * quantity[i];
+        double taxed = base + base * 0.05;
+        double discounted = base * 0.90;
+        double price = rule[i] == PRICING_TAXED ? taxed : base;
+        out[i] = (rule[i] == PRICING_BULK_DISCOUNT && quantity[i] >= 3) ? discounted : price;
+    }
+}
+
+// Prices each cart line into lineTotals and returns their sum
+inline double priceCart(const CartItem cart[], int count, double lineTotals[]) {
+    double basePrice[MAX_CART_ITEMS] = {};
+    int32_t rule[MAX_CART_ITEMS] = {}, quantity[MAX_CART_ITEMS] = {};
+    int n = count < MAX_CART_ITEMS ? count : MAX_CART_ITEMS;
+    for (int i = 0; i < n; ++i) {
+        const Product* p = cart[i].getProduct();
+        basePrice[i] = p ? p->getBasePrice() : 0.0;
+        rule[i] = p ? p->getPricingRule() : PRICING_PLAIN;
+        quantity[i] = cart[i].getQuantity();
+    }
+    priceLines(basePrice, rule, quantity, lineTotals, n);
+    double total = 0.0;
+    for (int i = 0; i < n; ++i) total += lineTotals[i];
+    return total;
+}
+
+// Base price and pricing rule of every product, by slot in NTSHOP, held in
+// two contiguous arrays for catalog-wide repricing and bulk quotes
+class PriceTable {
+    static constexpr size_t CHUNK = 256;  // lines gathered per priceLines call
+    vector<double> basePrices;
+    vector<int32_t> rules;
+
+public:
+    void add(const Product* p) {
+        basePrices.push_back(p->getBasePrice());
+        rules.push_back(p->getPricingRule());
+    }
+
+    size_t size() const { return basePrices.size(); }
+
+    // Prices the products in slots [first, first + count) at quantity each
+    void priceSlice(size_t first, size_t count, int quantity, double* out) const {
+        int32_t quantities[CHUNK];
+        for (size_t i = 0; i < CHUNK; ++i) quantities[i] = quantity;
+        for (size_t done = 0; done < count; done += CHUNK) {
+            size_t n = min(CHUNK, count - done);
+            priceLines(basePrices.data() + first + done, rules.data() + first + done, quantities, out + done, n);
+        }
+    }
+
+    // Prices quantities[i] units of the product in slots[i], for n lines
+    void quote(const int* slots, const int32_t* quantities, double* out, size_t n) const {
+        double base[CHUNK];
+        int32_t rule[CHUNK];
+        for (size_t done = 0; done < n; done += CHUNK) {
+            size_t m = min(CHUNK, n - done);
+            for (size_t i = 0; i < m; ++i) {
+                base[i] = basePrices[slots[done + i]];
+                rule[i] = rules[slots[done + i]];
+            }
+            priceLines(base, rule, quantities + done, out + done, m);
+        }
+    }
+
+    void clear() {
+        basePrices.clear();
+        rules.clear();
+    }
+};
+
+// One line of a placed order. The price is the line total charged at checkout,
+// so it stays what the customer paid even if the product later changes.
+struct OrderLine {
+    Product* product;  // NULL if the product is no longer in the catalog
+    int productId;
+    int quantity;
+    double price;
+};
+
+// Keeps one copy of each distinct text and hands out references to it that
+// stay valid for the life of the program. Looking up a text already in the
+// pool allocates nothing. Safe for concurrent use: texts are spread over
+// shards by hash, each with its own lock, so parallel loaders seldom wait.
+class StringPool {
+    static const int SHARDS = 16;
+    struct Shard {
+        mutex lock;
+        deque<string> texts;  // a deque never moves its elements
+        unordered_map<string_view, const string*> byText;
+    };
+    Shard shards[SHARDS];
+
+public:
+    const string& intern(string_view text) {
+        Shard& shard = shards[hash<string_view>()(text) % SHARDS];
+        lock_guard<mutex> lock(shard.lock);
+        unordered_map<string_view, const string*>::const_iterator it = shard.byText.find(text);
+        if (it != shard.byText.end()) return *it->second;
+        shard.texts.emplace_back(text);
+        const string& stored = shard.texts.back();
+        shard.byText.emplace(string_view(stored), &stored);
+        return stored;
+    }
+};
+
 class Order {
-    static int nextOrderId;
+    static atomic<int> nextOrderId;
+    static StringPool addressPool;  // a customer's orders usually share one address
     int orderId;
-    string customerUsername;
-    string deliveryAddress;
-    CartItem items[MAX_ORDER_ITEMS];
     int itemsCount;
+    uint32_t firstLine;  // this order's lines are [firstLine, firstLine + lineCount)
+    uint32_t lineCount;  // of the line buffer of the NTSHOP holding it
+    string customerUsername;
+    const string* deliveryAddress;  // in addressPool
     double totalCost;
-    string deliveryType;
     double deliveryCharge;
-    string paymentMethod;
-    string status;
+    OrderStatus status;
+    DeliveryType deliveryType;
+    PaymentMethod paymentMethod;
+
+    // Interned once, so that default-constructing orders in parallel loaders
+    // never waits on the pool's locks
+    static const string* emptyAddress() {
+        static const string* empty = &addressPool.intern("");
+        return empty;
+    }
 
 public:
     Order()
-        : orderId(0), customerUsername(""), deliveryAddress(""), itemsCount(0),
-          totalCost(0.0), deliveryType("Normal"), deliveryCharge(0.0),
-          paymentMethod(""), status("Placed") {}
+        : orderId(0), itemsCount(0), firstLine(0), lineCount(0), customerUsername(""),
+          deliveryAddress(emptyAddress()), totalCost(0.0), deliveryCharge(0.0),
+          status(STATUS_PLACED), deliveryType(DELIVERY_NORMAL), paymentMethod(PAYMENT_COD) {}
 
-    void initialize(const string& uname, const string& addr, CartItem cart[],
-                    int cartCount, const string& pMethod, const string& dType, double baseCost) {
-        orderId = nextOrderId++;
+    // Hands out the next order ID; safe to call from any thread
+    static int allocateId() { return nextOrderId.fetch_add(1); }
+
+    // Starts a new order with an ID from allocateId. Its count lines are expected
+    // at [first, first + count) of the line buffer; the caller writes them there.
+    void initialize(int id, const string& uname, const string& addr, uint32_t first, uint32_t count,
+                    PaymentMethod pMethod, DeliveryType dType, double baseCost) {
+        orderId = id;
         customerUsername = uname;
-        deliveryAddress = addr;
-        itemsCount = 0;
-        for (int i = 0; i < cartCount && i < MAX_ORDER_ITEMS; ++i) {
-            items[i] = cart[i];
-            itemsCount++;
-        }
+        deliveryAddress = &addressPool.intern(addr);
+        itemsCount = (int)count;
+        firstLine = first;
+        lineCount = count;
         paymentMethod = pMethod;
         deliveryType = dType;
-        deliveryCharge = (dType == "Urgent") ? 500.0 : 0.0;
+        deliveryCharge = (dType == DELIVERY_URGENT) ? 500.0 : 0.0;
         totalCost = baseCost + deliveryCharge;
-        status = "Placed";
+        status = STATUS_PLACED;
     }
 
     int getId() const { return orderId; }
-    string getUsername() const { return customerUsername; }
-    string getAddress() const { return deliveryAddress; }
-    string getStatus() const { return status; }
+    const string& getUsername() const { return customerUsername; }
+    const string& getAddress() const { return *deliveryAddress; }
+    OrderStatus getStatus() const { return status; }
+    const string& getStatusName() const { return ORDER_STATUS_NAMES[status]; }
     double getTotalCost() const { return totalCost; }
-    string getPaymentMethod() const { return paymentMethod; }
-    string getDeliveryType() const { return deliveryType; }
+    PaymentMethod getPaymentMethod() const { return paymentMethod; }
+    const string& getPaymentMethodName() const { return PAYMENT_METHOD_NAMES[paymentMethod]; }
+    DeliveryType getDeliveryType() const { return deliveryType; }
+    const string& getDeliveryTypeName() const { return DELIVERY_TYPE_NAMES[deliveryType]; }
     double getDeliveryCharge() const { return deliveryCharge; }
     int getItemsCount() const { return itemsCount; }
-    const CartItem& getItem(int index) const { return items[index]; }
+    uint32_t getFirstLine() const { return firstLine; }
+    uint32_t getLineCount() const { return lineCount; }
+    void setLines(uint32_t first, uint32_t count) { firstLine = first; lineCount = count; }
 
-    void setStatus(const string& s) { status = s; }
+    void setStatus(OrderStatus s) { status = s; }
     void setOrderId(int id) { orderId = id; }
     
     // Static method to get next order ID
@@ -204,64 +660,104 @@ public:
     
     // Static method to update next order ID if needed
     static void updateNextOrderId(int id) { 
-        if (id >= nextOrderId) {
-            nextOrderId = id + 1;
-        }
-    }
-
-    void displayOrder() const {
-        cout << "\n--- Order ID: " << orderId << " ---" << endl;
-        cout << "  Customer: " << customerUsername << endl;
-        cout << "  Address: " << deliveryAddress << endl;
-        cout << "  Delivery Type: " << deliveryType << " (" << (deliveryType == "Urgent" ? "3 days" : "5 days") << ")" << endl;
-        cout << "  Payment: " << paymentMethod << endl;
-        cout << "  Status: " << status << endl;
-        cout << "  Items:" << endl;
-        for (int i = 0; i < itemsCount; ++i) {
-            Product* p = items[i].getProduct();
-            if (p) {
-                cout << "    - " << p->getName()
-                     << " x " << items[i].getQuantity()
-                     << " @ PKR " << fixed << setprecision(2) << items[i].getTotalPrice() << endl;
-            }
+        int next = nextOrderId;
+        while (id >= next && !nextOrderId.compare_exchange_weak(next, id + 1)) {}
+    }
+
+    // Appends the order's listing entry. lines points at this order's first
+    // line in the shop's line buffer.
+    void renderOrder(RenderBuffer& out, const OrderLine* lines) const {
+        out << "\n--- Order ID: " << orderId << " ---\n";
+        out << "  Customer: " << customerUsername << '\n';
+        out << "  Address: " << *deliveryAddress << '\n';
+        out << "  Delivery Type: " << getDeliveryTypeName() << " (" << (deliveryType == DELIVERY_URGENT ? "3 days" : "5 days") << ")\n";
+        out << "  Payment: " << getPaymentMethodName() << '\n';
+        out << "  Status: " << getStatusName() << '\n';
+        out << "  Items:\n";
+        for (uint32_t i = 0; i < lineCount; ++i) {
+            const OrderLine& line = lines[i];
+            out << "    - ";
+            if (line.product) out << line.product->getName();
+            else out << "Product #" << line.productId;
+            out << " x " << line.quantity << " @ PKR " << line.price << '\n';
         }
-        cout << "  Delivery Charge: PKR " << fixed << setprecision(2) << deliveryCharge << endl;
-        cout << "  FINAL TOTAL: PKR " << fixed << setprecision(2) << totalCost << endl;
+        out << "  Delivery Charge: PKR " << deliveryCharge << '\n';
+        out << "  FINAL TOTAL: PKR " << totalCost << '\n';
     }
     
+    // Amounts are written in full, as this is also the journal's ORDER record
+    // and a replay must give back the exact totals
+    void writeFileString(ostream& out) const {
+        streamsize precision = out.precision(17);
+        out << orderId << "|" << customerUsername << "|" << *deliveryAddress << "|"
+            << itemsCount << "|" << totalCost << "|" << getDeliveryTypeName() << "|"
+            << deliveryCharge << "|" << getPaymentMethodName() << "|" << getStatusName();
+        out.precision(precision);
+    }
+
     string toFileString() const {
         stringstream ss;
-        ss << orderId << "|" << customerUsername << "|" << deliveryAddress << "|"
-           << itemsCount << "|" << totalCost << "|" << deliveryType << "|"
-           << deliveryCharge << "|" << paymentMethod << "|" << status;
+        writeFileString(ss);
         return ss.str();
     }
-    
-    void fromFileString(const string& fileString) {
-        stringstream ss(fileString);
-        string token;
-        string tokens[9];
-        int tokenCount = 0;
-        
-        while (getline(ss, token, '|') && tokenCount < 9) {
-            tokens[tokenCount++] = token;
+
+    // Line items as productId:quantity:price entries separated by commas, the
+    // extra field of an ORDER journal event. lines is as for renderOrder.
+    void writeLines(ostream& out, const OrderLine* lines) const {
+        streamsize precision = out.precision(17);
+        for (uint32_t i = 0; i < lineCount; ++i) {
+            if (i > 0) out << ",";
+            out << lines[i].productId << ":" << lines[i].quantity << ":" << lines[i].price;
         }
-        
-        if (tokenCount >= 9) {
-            orderId = stoi(tokens[0]);
-            customerUsername = tokens[1];
-            deliveryAddress = tokens[2];
-            itemsCount = stoi(tokens[3]);
-            totalCost = stod(tokens[4]);
-            deliveryType = tokens[5];
-            deliveryCharge = stod(tokens[6]);
-            paymentMethod = tokens[7];
-            status = tokens[8];
+        out.precision(precision);
+    }
+    
+    // Sets every persisted field at once, used when loading a binary snapshot
+    void restore(int id, const string& uname, string_view addr, int count, double total,
+                 DeliveryType dType, double dCharge, PaymentMethod pMethod, OrderStatus s) {
+        orderId = id;
+        customerUsername = uname;
+        deliveryAddress = &addressPool.intern(addr);
+        itemsCount = count;
+        totalCost = total;
+        deliveryType = dType;
+        deliveryCharge = dCharge;
+        paymentMethod = pMethod;
+        status = s;
+    }
+
+    // Returns false, leaving the order unchanged, if the record is malformed
+    // or names a delivery type, payment method or status that does not exist
+    bool fromFileString(string_view fileString) {
+        string_view tokens[9];
+        if (splitFields(fileString, '|', tokens, 9) < 9) return false;
+
+        int id, count;
+        double total, charge;
+        if (!parseInt(tokens[0], id) || !parseInt(tokens[3], count) ||
+            !parseDouble(tokens[4], total) || !parseDouble(tokens[6], charge)) {
+            return false;
         }
+        int dType = lookupName(tokens[5], DELIVERY_TYPE_NAMES, NUM_DELIVERY_TYPES);
+        int pMethod = lookupName(tokens[7], PAYMENT_METHOD_NAMES, NUM_PAYMENT_METHODS);
+        int s = lookupName(tokens[8], ORDER_STATUS_NAMES, NUM_ORDER_STATUSES);
+        if (dType < 0 || pMethod < 0 || s < 0) return false;
+
+        orderId = id;
+        customerUsername.assign(tokens[1]);
+        deliveryAddress = &addressPool.intern(tokens[2]);
+        itemsCount = count;
+        totalCost = total;
+        deliveryType = (DeliveryType)dType;
+        deliveryCharge = charge;
+        paymentMethod = (PaymentMethod)pMethod;
+        status = (OrderStatus)s;
+        return true;
     }
 };
 
-int Order::nextOrderId = 1001;
+atomic<int> Order::nextOrderId(1001);
+StringPool Order::addressPool;
 
 class NTSHOP;
 
@@ -276,7 +772,7 @@ public:
     virtual ~User() {}
     virtual void startSession() = 0;
     virtual string getUserType() const = 0;
-    string getUsername() const { return username; }
+    const string& getUsername() const { return username; }
     string getPassword() const { return password; }
     string getAddress() const { return address; }
     void setAddress(const string& a) { address = a; }
@@ -285,13 +781,12 @@ public:
         return getUserType() + "|" + username + "|" + password + "|" + address;
     }
     
-    void fromFileString(const string& fileString) {
-        stringstream ss(fileString);
-        string type;
-        getline(ss, type, '|');  // Skip type
-        getline(ss, username, '|');
-        getline(ss, password, '|');
-        getline(ss, address, '|');
+    void fromFileString(string_view fileString) {
+        string_view tokens[4];  // type, username, password, address
+        splitFields(fileString, '|', tokens, 4);
+        username.assign(tokens[1]);
+        password.assign(tokens[2]);
+        address.assign(tokens[3]);
     }
 };
 
@@ -312,7 +807,10 @@ public:
     void viewOrderHistory() const;
     double calculateCartTotal() const;
     bool addToCart(Product* p, int q);
+    int placeCartOrder(const string& deliveryAddress, PaymentMethod payment, DeliveryType delivery);
     void clearCart();
+    void promptAddToCart();
+    void browseByPrice();
 };
 
 class Admin : public User {
@@ -329,99 +827,992 @@ public:
     void searchCustomer() const;
 };
 
-class NTSHOP {
-    Product* allProducts[MAX_PRODUCTS];
-    int productCount;
-    User* allUsers[MAX_USERS];
-    int userCount;
-    Order allOrders[MAX_ORDERS];
-    int orderCount;
+// Open-addressing hash index from an integer key (e.g. a product ID) to the
+// slot that object occupies in its NTSHOP array. Keys are never removed, so
+// plain linear probing without tombstones is enough.
+class IdIndex {
+    struct Entry {
+        int key;
+        int slot;  // -1 marks an empty bucket
+    };
+    vector<Entry> table;
+    int used;
+    int shift;  // 32 - log2(table size), for Fibonacci hashing
+
+    int bucketOf(int key) const {
+        return (int)(((unsigned int)key * 2654435769u) >> shift);
+    }
+
+    void rehash(int newSize) {
+        vector<Entry> old;
+        old.swap(table);
+        table.assign(newSize, Entry{0, -1});
+        shift = 32;
+        for (int n = newSize; n > 1; n >>= 1) shift--;
+        used = 0;
+        for (const Entry& e : old)
+            if (e.slot >= 0) insert(e.key, e.slot);
+    }
 
 public:
-    NTSHOP() : productCount(0), userCount(0), orderCount(0) {
-        loadUsers();
-        loadProducts();
-        loadOrders();
-        
-        // If no admin exists, create default admin
-        if (findUser("admin") == NULL) {
-            allUsers[userCount++] = new Admin("admin", "admin123", this);
+    IdIndex() : used(0), shift(32) {}
+
+    // Make room for n keys without further rehashing (load factor <= 0.5)
+    void reserve(int n) {
+        int size = 16;
+        while (size < 2 * n) size <<= 1;
+        if (size > (int)table.size()) rehash(size);
+    }
+
+    // Returns false (and keeps the existing slot) if the key is already present
+    bool insert(int key, int slot) {
+        if (2 * (used + 1) > (int)table.size()) rehash(table.empty() ? 16 : 2 * (int)table.size());
+        int mask = (int)table.size() - 1;
+        for (int b = bucketOf(key); ; b = (b + 1) & mask) {
+            if (table[b].slot < 0) {
+                table[b].key = key;
+                table[b].slot = slot;
+                used++;
+                return true;
+            }
+            if (table[b].key == key) return false;
         }
-        
-        // If no products exist, create default ones
-        if (productCount == 0) {
-            addDefaultProducts();
+    }
+
+    // Returns the slot stored for key, or -1 if it is not indexed
+    int find(int key) const {
+        if (used == 0) return -1;
+        int mask = (int)table.size() - 1;
+        for (int b = bucketOf(key); table[b].slot >= 0; b = (b + 1) & mask) {
+            if (table[b].key == key) return table[b].slot;
         }
+        return -1;
     }
 
-    ~NTSHOP() {
-        saveData();  // Save all data before destruction
-        for (int i = 0; i < productCount; ++i) delete allProducts[i];
-        for (int i = 0; i < userCount; ++i) delete allUsers[i];
+    int size() const { return used; }
+
+    void clear() {
+        table.clear();
+        used = 0;
+        shift = 32;
     }
+};
 
-    // Helper function to validate username
-    static bool isValidUsername(const string& username) {
-        if (username.length() < MIN_USERNAME_LENGTH || username.length() > MAX_USERNAME_LENGTH) {
-            return false;
+// Open-addressing hash index from a username to the user's slot in NTSHOP.
+// Each bucket keeps the full hash of its key, so a probe only compares strings
+// when the hashes already match. Keys point at the username owned by the User
+// object itself instead of holding a second copy.
+class NameIndex {
+    struct Entry {
+        unsigned int hash;
+        int slot;  // -1 marks an empty bucket
+        const string* key;
+    };
+    vector<Entry> table;
+    int used;
+    int shift;  // 32 - log2(table size), for Fibonacci hashing
+
+    int bucketOf(unsigned int hash) const {
+        return (int)((hash * 2654435769u) >> shift);
+    }
+
+    void rehash(int newSize) {
+        vector<Entry> old;
+        old.swap(table);
+        table.assign(newSize, Entry{0, -1, NULL});
+        shift = 32;
+        for (int n = newSize; n > 1; n >>= 1) shift--;
+        int mask = newSize - 1;
+        for (const Entry& e : old) {
+            if (e.slot < 0) continue;
+            int b = bucketOf(e.hash);
+            while (table[b].slot >= 0) b = (b + 1) & mask;
+            table[b] = e;
         }
-        // Check if username contains only alphanumeric characters
-        for (char c : username) {
-            if (!isalnum(c)) {
-                return false;
+    }
+
+public:
+    NameIndex() : used(0), shift(32) {}
+
+    // FNV-1a
+    static unsigned int hashOf(const string& s) {
+        unsigned int h = 2166136261u;
+        for (char c : s) {
+            h ^= (unsigned char)c;
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    void reserve(int n) {
+        int size = 16;
+        while (size < 2 * n) size <<= 1;
+        if (size > (int)table.size()) rehash(size);
+    }
+
+    // key must stay alive and unchanged while it is indexed.
+    // Returns false (and keeps the existing slot) if the name is already present.
+    bool insert(const string* key, int slot) {
+        if (2 * (used + 1) > (int)table.size()) rehash(table.empty() ? 16 : 2 * (int)table.size());
+        unsigned int h = hashOf(*key);
+        int mask = (int)table.size() - 1;
+        for (int b = bucketOf(h); ; b = (b + 1) & mask) {
+            if (table[b].slot < 0) {
+                table[b].hash = h;
+                table[b].slot = slot;
+                table[b].key = key;
+                used++;
+                return true;
             }
+            if (table[b].hash == h && *table[b].key == *key) return false;
         }
-        return true;
     }
-    
-    // Helper function to validate password
-    static bool isValidPassword(const string& password) {
-        if (password.length() < MIN_PASSWORD_LENGTH || password.length() > MAX_PASSWORD_LENGTH) {
-            return false;
+
+    // Returns the slot stored for name, or -1 if it is not indexed
+    int find(const string& name) const {
+        if (used == 0) return -1;
+        unsigned int h = hashOf(name);
+        int mask = (int)table.size() - 1;
+        for (int b = bucketOf(h); table[b].slot >= 0; b = (b + 1) & mask) {
+            if (table[b].hash == h && *table[b].key == name) return table[b].slot;
         }
-        // Check if password contains at least one digit and one letter
-        bool hasDigit = false;
-        bool hasLetter = false;
-        for (char c : password) {
-            if (isdigit(c)) hasDigit = true;
-            if (isalpha(c)) hasLetter = true;
+        return -1;
+    }
+
+    int size() const { return used; }
+};
+
+// ========== BINARY SNAPSHOT ==========
+// shop.snap holds a header, then fixed-width product, user, order and order
+// line records, then one string heap that the records point into. Identical strings (status
+// names, a customer's repeated address) are stored in the heap only once.
+const char SNAPSHOT_MAGIC[8] = { 'N', 'T', 'S', 'H', 'O', 'P', 'S', 'N' };
+const uint32_t SNAPSHOT_VERSION = 2;  // 2: order line items
+
+// Product type tags as written in products.txt, indexed by the snapshot type code
+const string PRODUCT_TYPES[] = { "FASHION", "EDUCATION", "AUTOMOBILE", "ELECTRONICS" };
+const int NUM_PRODUCT_TYPES = 4;
+
+struct SnapshotString {
+    uint32_t offset;  // into the string heap
+    uint32_t length;
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t productCount;
+    uint32_t userCount;
+    uint32_t orderCount;
+    uint32_t lineCount;
+    uint32_t reserved;
+    uint64_t heapSize;
+};
+
+struct ProductRecord {
+    int32_t id;
+    int32_t type;  // index into PRODUCT_TYPES
+    double price;
+    SnapshotString name;
+    SnapshotString subCategory;
+};
+
+struct UserRecord {
+    int32_t type;  // 0 = admin, 1 = customer
+    int32_t reserved;
+    SnapshotString username;
+    SnapshotString password;
+    SnapshotString address;
+};
+
+struct OrderRecord {
+    int32_t id;
+    int32_t itemsCount;
+    double totalCost;
+    double deliveryCharge;
+    SnapshotString customer;
+    SnapshotString address;
+    SnapshotString deliveryType;
+    SnapshotString paymentMethod;
+    SnapshotString status;
+};
+
+// Also the record format of order_items.dat. Lines are stored grouped by
+// order, in the same order as the orders themselves.
+struct OrderLineRecord {
+    int32_t orderId;
+    int32_t productId;
+    int32_t quantity;
+    int32_t reserved;
+    double price;
+};
+
+static_assert(sizeof(SnapshotHeader) == 40 && sizeof(ProductRecord) == 32 &&
+              sizeof(UserRecord) == 32 && sizeof(OrderRecord) == 64 &&
+              sizeof(OrderLineRecord) == 24,
+              "snapshot records must keep a fixed layout");
+
+// Read-only view of a whole file: memory-mapped where mmap is available,
+// read into a buffer otherwise
+class MappedFile {
+    bool opened;
+    const char* bytes;
+    size_t length;
+    vector<char> buffer;
+#ifndef _WIN32
+    void* mapping;
+#endif
+
+public:
+    MappedFile(const string& path) : opened(false), bytes(NULL), length(0) {
+#ifndef _WIN32
+        mapping = NULL;
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        opened = true;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* m = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (m != MAP_FAILED) {
+                mapping = m;
+                bytes = (const char*)m;
+                length = (size_t)st.st_size;
+            }
         }
-        return hasDigit && hasLetter;
+        close(fd);
+#else
+        ifstream inFile(path, ios::binary);
+        if (!inFile) return;
+        opened = true;
+        buffer.assign(istreambuf_iterator<char>(inFile), istreambuf_iterator<char>());
+        bytes = buffer.data();
+        length = buffer.size();
+#endif
     }
-    
-    // Helper function to validate account number
-    static bool isValidAccountNumber(const string& accNum) {
-        if (accNum.length() != ACCOUNT_NUMBER_LENGTH) {
-            return false;
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (mapping) munmap(mapping, length);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const { return opened; }  // an empty file is open but has no data
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+// Builds the string heap while a snapshot is written
+class SnapshotHeapWriter {
+    string heap;
+    unordered_map<string, uint32_t> offsets;
+public:
+    SnapshotString add(const string& s) {
+        SnapshotString ref;
+        ref.length = (uint32_t)s.size();
+        unordered_map<string, uint32_t>::iterator it = offsets.find(s);
+        if (it != offsets.end()) {
+            ref.offset = it->second;
+        } else {
+            ref.offset = (uint32_t)heap.size();
+            offsets[s] = ref.offset;
+            heap += s;
         }
-        // Check if account number contains only digits
-        for (char c : accNum) {
-            if (!isdigit(c)) {
-                return false;
+        return ref;
+    }
+    const string& bytes() const { return heap; }
+};
+
+// ========== PRODUCT SEARCH ==========
+// Slots of the products containing one word, ascending. Each slot is stored as
+// a varint delta from the previous one; every SKIP_INTERVAL entries a skip
+// point records where a block starts so a search can jump over whole blocks.
+class PostingList {
+public:
+    static const int SKIP_INTERVAL = 64;
+
+    struct SkipPoint {
+        int previous;  // slot just before the block (-1 for the first block)
+        int offset;    // byte offset of the block
+    };
+
+private:
+    vector<unsigned char> bytes;
+    vector<SkipPoint> skips;
+    int last;
+    int count;
+
+public:
+    PostingList() : last(-1), count(0) {}
+
+    // Slots must arrive in ascending order; repeats of the last slot are ignored
+    void add(int slot) {
+        if (slot <= last) return;
+        if (count % SKIP_INTERVAL == 0) {
+            SkipPoint skip = { last, (int)bytes.size() };
+            skips.push_back(skip);
+        }
+        unsigned int delta = (unsigned int)(slot - last);
+        while (delta >= 0x80) {
+            bytes.push_back((unsigned char)(delta | 0x80));
+            delta >>= 7;
+        }
+        bytes.push_back((unsigned char)delta);
+        last = slot;
+        count++;
+    }
+
+    int size() const { return count; }
+    size_t byteSize() const { return bytes.size() + skips.size() * sizeof(SkipPoint); }
+
+    // Walks a posting list in order
+    class Cursor {
+        const PostingList* list;
+        int offset;
+        int value;
+        int position;  // entries decoded so far
+    public:
+        explicit Cursor(const PostingList* l) : list(l), offset(0), value(-1), position(0) {}
+
+        // Next slot in the list, or -1 at the end
+        int next() {
+            if (position >= list->count) return -1;
+            position++;
+            unsigned int delta = 0;
+            int shift = 0;
+            unsigned char b;
+            do {
+                b = list->bytes[offset++];
+                delta |= (unsigned int)(b & 0x7f) << shift;
+                shift += 7;
+            } while (b & 0x80);
+            value += (int)delta;
+            return value;
+        }
+
+        // First slot >= target, or -1 if there is none
+        int seek(int target) {
+            if (value >= target) return value;
+            // If target lies past the next block, jump to the last block that
+            // starts before it instead of decoding everything in between
+            const vector<SkipPoint>& skips = list->skips;
+            int nextBlock = position / SKIP_INTERVAL + 1;
+            if (nextBlock < (int)skips.size() && skips[nextBlock].previous < target) {
+                int lo = nextBlock, hi = (int)skips.size() - 1, best = nextBlock;
+                while (lo <= hi) {
+                    int mid = (lo + hi) / 2;
+                    if (skips[mid].previous < target) { best = mid; lo = mid + 1; }
+                    else hi = mid - 1;
+                }
+                offset = skips[best].offset;
+                value = skips[best].previous;
+                position = best * SKIP_INTERVAL;
             }
+            int v;
+            while ((v = next()) >= 0 && v < target) {}
+            return v;
         }
-        return true;
+    };
+};
+
+// Keyword index over product names and sub-categories. Words are lowercased
+// runs of letters and digits.
+class ProductSearchIndex {
+    unordered_map<string, PostingList> postings;
+
+public:
+    static vector<string> tokenize(const string& text) {
+        vector<string> words;
+        string word;
+        for (char c : text) {
+            if (isalnum((unsigned char)c)) {
+                word += (char)tolower((unsigned char)c);
+            } else if (!word.empty()) {
+                words.push_back(word);
+                word.clear();
+            }
+        }
+        if (!word.empty()) words.push_back(word);
+        return words;
     }
 
-    void addDefaultProducts() {
-        // ========== FASHION PRODUCTS  ==========
-        addProduct(new FashionProduct(1, "Slim Fit Jeans", 3500.0, "Men's Clothing"));
-        addProduct(new FashionProduct(2, "Leather Handbag", 6800.0, "Women's Accessories"));
-        addProduct(new FashionProduct(3, "Cotton T-Shirt", 1200.0, "Men's Clothing"));
-        addProduct(new FashionProduct(4, "Summer Dress", 4500.0, "Women's Clothing"));
-        addProduct(new FashionProduct(5, "Leather Belt", 1500.0, "Accessories"));
-        addProduct(new FashionProduct(6, "Sports Shoes", 5500.0, "Footwear"));
-        addProduct(new FashionProduct(7, "Woolen Sweater", 3800.0, "Winter Wear"));
-        addProduct(new FashionProduct(8, "Formal Suit", 12000.0, "Men's Clothing"));
-        addProduct(new FashionProduct(9, "Evening Gown", 8500.0, "Women's Clothing"));
-        addProduct(new FashionProduct(10, "Running Shoes", 4200.0, "Footwear"));
-        addProduct(new FashionProduct(11, "Leather Jacket", 9500.0, "Outerwear"));
-        addProduct(new FashionProduct(12, "Casual Shirt", 1800.0, "Men's Clothing"));
-        addProduct(new FashionProduct(13, "Skirt", 2800.0, "Women's Clothing"));
-        addProduct(new FashionProduct(14, "Wrist Watch", 6500.0, "Accessories"));
-        addProduct(new FashionProduct(15, "Sunglasses", 2200.0, "Accessories"));
-        addProduct(new FashionProduct(16, "Backpack", 3200.0, "Bags"));
-        addProduct(new FashionProduct(17, "Swimwear", 2500.0, "Beachwear"));
+    // Slots must be added in ascending order, as NTSHOP appends products
+    void add(int slot, const string& name, const string& subCategory) {
+        vector<string> words = tokenize(name + " " + subCategory);
+        for (size_t i = 0; i < words.size(); ++i) postings[words[i]].add(slot);
+    }
+
+    // Slots of the products that contain every word of the query, ascending
+    vector<int> search(const string& query) const {
+        vector<int> result;
+        vector<string> words = tokenize(query);
+        if (words.empty()) return result;
+
+        vector<const PostingList*> lists;
+        for (size_t i = 0; i < words.size(); ++i) {
+            unordered_map<string, PostingList>::const_iterator it = postings.find(words[i]);
+            if (it == postings.end()) return result;
+            lists.push_back(&it->second);
+        }
+        // Drive the intersection from the rarest word
+        sort(lists.begin(), lists.end(),
+             [](const PostingList* a, const PostingList* b) { return a->size() < b->size(); });
+
+        vector<PostingList::Cursor> cursors;
+        for (size_t i = 1; i < lists.size(); ++i) cursors.push_back(PostingList::Cursor(lists[i]));
+
+        PostingList::Cursor driver(lists[0]);
+        for (int slot = driver.next(); slot >= 0; slot = driver.next()) {
+            bool inAll = true;
+            for (size_t i = 0; i < cursors.size() && inAll; ++i) {
+                int found = cursors[i].seek(slot);
+                if (found < 0) return result;  // that list is exhausted
+                inAll = found == slot;
+            }
+            if (inAll) result.push_back(slot);
+        }
+        return result;
+    }
+
+    void clear() { postings.clear(); }
+};
+
+// ========== PRICE ORDER ==========
+// Product slots sorted by base price, with equal prices in slot order: one
+// list per category and one for the whole catalog (ANY_CATEGORY). A price
+// band is found by binary search and a page of it is a slice, so neither
+// costs more than the page it returns.
+// Products added since the last query wait in an unsorted tail of their
+// lists; the next query sorts just those and merges them in. Loading a
+// catalog is therefore one sort rather than an insertion per product. The
+// merge is the only write a query makes and is done under mergeLock, since
+// catalog readers take no other lock.
+const int ANY_CATEGORY = -1;
+
+class PriceIndex {
+    struct Entry {
+        double price;
+        int slot;
+        bool operator<(const Entry& other) const {
+            return price != other.price ? price < other.price : slot < other.slot;
+        }
+    };
+    static const int LISTS = NUM_CATEGORIES + 1;  // the last one holds every product
+
+    mutable vector<Entry> entries[LISTS];
+    mutable size_t sortedCount[LISTS];  // entries[i][0, sortedCount[i]) are in order
+    mutable atomic<bool> hasPending;
+    mutable mutex mergeLock;
+
+    static int listOf(int category) { return category == ANY_CATEGORY ? NUM_CATEGORIES : category; }
+
+    void mergePending() const {
+        if (!hasPending.load(memory_order_acquire)) return;
+        lock_guard<mutex> lock(mergeLock);
+        if (!hasPending.load(memory_order_relaxed)) return;
+        for (int i = 0; i < LISTS; ++i) {
+            vector<Entry>& list = entries[i];
+            sort(list.begin() + sortedCount[i], list.end());
+            inplace_merge(list.begin(), list.begin() + sortedCount[i], list.end());
+            sortedCount[i] = list.size();
+        }
+        hasPending.store(false, memory_order_release);
+    }
+
+    // Entries of category's list priced within [minPrice, maxPrice]
+    pair<const Entry*, const Entry*> band(int category, double minPrice, double maxPrice) const {
+        mergePending();
+        const vector<Entry>& list = entries[listOf(category)];
+        const Entry* first = lower_bound(list.data(), list.data() + list.size(), minPrice,
+                                         [](const Entry& e, double price) { return e.price < price; });
+        const Entry* last = upper_bound(first, list.data() + list.size(), maxPrice,
+                                        [](double price, const Entry& e) { return price < e.price; });
+        return make_pair(first, last);
+    }
+
+public:
+    PriceIndex() : hasPending(false) {
+        for (int i = 0; i < LISTS; ++i) sortedCount[i] = 0;
+    }
+
+    // Not safe to call while the index is being read
+    void add(int slot, Category category, double price) {
+        Entry e = { price, slot };
+        entries[category].push_back(e);
+        entries[NUM_CATEGORIES].push_back(e);
+        hasPending.store(true, memory_order_release);
+    }
+
+    // How many products of category (or ANY_CATEGORY) cost between minPrice
+    // and maxPrice, inclusive
+    size_t count(int category, double minPrice, double maxPrice) const {
+        pair<const Entry*, const Entry*> b = band(category, minPrice, maxPrice);
+        return (size_t)(b.second - b.first);
+    }
+
+    // Slots of those products at positions [offset, offset + count) of the
+    // band, cheapest first or, if descending, dearest first
+    vector<int> slotsByPrice(int category, double minPrice, double maxPrice, bool descending,
+                             size_t offset, size_t count) const {
+        pair<const Entry*, const Entry*> b = band(category, minPrice, maxPrice);
+        size_t size = (size_t)(b.second - b.first);
+        vector<int> slots;
+        for (size_t i = offset; i < size && i - offset < count; ++i)
+            slots.push_back(descending ? b.second[-1 - (ptrdiff_t)i].slot : b.first[i].slot);
+        return slots;
+    }
+
+    void clear() {
+        lock_guard<mutex> lock(mergeLock);
+        for (int i = 0; i < LISTS; ++i) {
+            entries[i].clear();
+            sortedCount[i] = 0;
+        }
+        hasPending.store(false);
+    }
+};
+
+// ========== ADDRESS SEARCH ==========
+// Index of every three-byte substring (trigram) of a set of texts, used to
+// answer substring queries without scanning all of them. Each trigram maps to
+// the slots of the texts containing it. A query only narrows the candidates;
+// callers confirm each one with a real substring check.
+//
+// Because of that check, removing a text does not touch its lists: the stale
+// entries are simply filtered out later. New entries are appended unsorted and
+// merged into the sorted part the next time a query reads that list. Once
+// stale entries outnumber live ones, needsRebuild() asks the owner to rebuild.
+class TrigramIndex {
+    struct Posting {
+        vector<int> slots;  // slots[0, sorted) ascending and unique, then appended ones
+        size_t sorted;
+        Posting() : sorted(0) {}
+    };
+    mutable unordered_map<uint32_t, Posting> postings;
+    size_t liveEntries;
+    size_t staleEntries;
+    // Queries sort the slots appended to the lists they read; this lets
+    // several run at once. add and remove must not race with queries.
+    mutable mutex settleLock;
+
+    static void trigramsOf(const string& text, vector<uint32_t>& out) {
+        out.clear();
+        for (size_t i = 0; i + 3 <= text.size(); ++i) {
+            out.push_back(((uint32_t)(unsigned char)text[i] << 16) |
+                          ((uint32_t)(unsigned char)text[i + 1] << 8) |
+                          (uint32_t)(unsigned char)text[i + 2]);
+        }
+        sort(out.begin(), out.end());
+        out.erase(unique(out.begin(), out.end()), out.end());
+    }
+
+    static void settle(Posting& p) {
+        if (p.sorted == p.slots.size()) return;
+        vector<int>::iterator middle = p.slots.begin() + p.sorted;
+        sort(middle, p.slots.end());
+        inplace_merge(p.slots.begin(), middle, p.slots.end());
+        p.slots.erase(unique(p.slots.begin(), p.slots.end()), p.slots.end());
+        p.sorted = p.slots.size();
+    }
+
+    // First position in [from, end) holding a value >= target, found by
+    // doubling steps from the current position and then binary search
+    static vector<int>::const_iterator gallop(vector<int>::const_iterator from,
+                                              vector<int>::const_iterator end, int target) {
+        size_t step = 1;
+        vector<int>::const_iterator probe = from;
+        while (end - probe > (ptrdiff_t)step && *(probe + step) < target) {
+            probe += step;
+            step <<= 1;
+        }
+        vector<int>::const_iterator limit = end - probe > (ptrdiff_t)step ? probe + step + 1 : end;
+        return lower_bound(probe, limit, target);
+    }
+
+public:
+    // Queries shorter than this cannot use the index
+    static const size_t MIN_QUERY_LENGTH = 3;
+
+    TrigramIndex() : liveEntries(0), staleEntries(0) {}
+
+    void add(int slot, const string& text) {
+        vector<uint32_t> grams;
+        trigramsOf(text, grams);
+        for (size_t i = 0; i < grams.size(); ++i) {
+            Posting& p = postings[grams[i]];
+            if (p.slots.empty() || p.slots.back() != slot) {
+                p.slots.push_back(slot);
+                if (p.sorted + 1 == p.slots.size() && (p.sorted == 0 || p.slots[p.sorted - 1] < slot)) p.sorted++;
+            }
+        }
+        liveEntries += grams.size();
+    }
+
+    void remove(int slot, const string& text) {
+        (void)slot;
+        vector<uint32_t> grams;
+        trigramsOf(text, grams);
+        liveEntries -= min(liveEntries, grams.size());
+        staleEntries += grams.size();
+    }
+
+    bool needsRebuild() const { return staleEntries > 1024 && staleEntries > liveEntries; }
+
+    // Ascending slots of the texts that (may) contain query: a superset of
+    // the texts containing it. query must be at least MIN_QUERY_LENGTH long.
+    vector<int> candidates(const string& query) const {
+        vector<int> result;
+        vector<uint32_t> grams;
+        trigramsOf(query, grams);
+
+        vector<const vector<int>*> lists;
+        {
+            // A settled list is not written again until the next add
+            lock_guard<mutex> lock(settleLock);
+            for (size_t i = 0; i < grams.size(); ++i) {
+                unordered_map<uint32_t, Posting>::iterator entry = postings.find(grams[i]);
+                if (entry == postings.end()) return result;
+                settle(entry->second);
+                lists.push_back(&entry->second.slots);
+            }
+        }
+        if (lists.empty()) return result;
+        sort(lists.begin(), lists.end(),
+             [](const vector<int>* a, const vector<int>* b) { return a->size() < b->size(); });
+
+        result = *lists[0];
+        for (size_t i = 1; i < lists.size() && !result.empty(); ++i) {
+            // Once the remaining lists dwarf the candidates, the caller's
+            // substring check is cheaper than probing them
+            if (lists[i]->size() > 16 * result.size()) break;
+            const vector<int>& list = *lists[i];
+            vector<int>::const_iterator from = list.begin();
+            size_t kept = 0;
+            for (size_t j = 0; j < result.size(); ++j) {
+                from = gallop(from, list.end(), result[j]);
+                if (from == list.end()) break;
+                if (*from == result[j]) result[kept++] = result[j];
+            }
+            result.resize(kept);
+        }
+        return result;
+    }
+
+    void clear() {
+        postings.clear();
+        liveEntries = 0;
+        staleEntries = 0;
+    }
+};
+
+// Running totals of one customer's orders, kept in step with every order
+// placed and every status change so that they never need recounting
+struct CustomerTotals {
+    int orders;       // orders that are not cancelled
+    double spent;     // what those orders cost
+    int lastOrderId;  // the customer's latest order of any status, 0 if none
+
+    CustomerTotals() : orders(0), spent(0.0), lastOrderId(0) {}
+};
+
+// ========== SALES REPORTS ==========
+// One group of a sales report: how many orders (units, for categories) and
+// what they came to
+struct SalesRow {
+    long long count;
+    double revenue;
+
+    SalesRow() : count(0), revenue(0.0) {}
+};
+
+// Categories get one extra group, for lines whose product is no longer in
+// the catalog
+const int NUM_SALES_CATEGORIES = NUM_CATEGORIES + 1;
+const int MAX_SALES_GROUPS = NUM_SALES_CATEGORIES;
+
+// The fields the sales reports group and add up, copied out of the orders
+// and their line items into one array per field, like PriceTable. A report
+// reads only the arrays it needs, front to back, instead of every Order.
+// Kept in step with the shop's orders and line buffer by NTSHOP.
+class SalesColumns {
+    // By slot in the shop's orders
+    vector<uint8_t> orderStatus;
+    vector<uint8_t> deliveryType;
+    vector<uint8_t> paymentMethod;
+    vector<double> orderTotal;
+    // By position in the shop's line buffer
+    vector<uint8_t> lineCategory;  // NUM_CATEGORIES if the product is gone
+    vector<uint8_t> lineStatus;    // the status of the line's order
+    vector<int32_t> lineQuantity;
+    vector<double> linePrice;
+
+    // Adds up rows [0, n) by group keys[i], skipping rows whose status is
+    // skip. A row counts as counts[i], or 1 if counts is NULL. Chunks of rows
+    // are summed on up to workers threads and combined in chunk order, so
+    // the totals do not depend on how many threads ran.
+    static vector<SalesRow> sumByGroup(const uint8_t* keys, int groups, const uint8_t* statuses, int skip,
+                                       const int32_t* counts, const double* values, size_t n, int workers) {
+        size_t chunks = (n + SALES_SCAN_CHUNK - 1) / SALES_SCAN_CHUNK;
+        vector<SalesRow> partial(chunks * groups);
+        runInParallel(chunks, workers, [&](size_t c) {
+            long long count[MAX_SALES_GROUPS] = {};
+            double revenue[MAX_SALES_GROUPS] = {};
+            size_t end = min(n, (c + 1) * SALES_SCAN_CHUNK);
+            for (size_t i = c * SALES_SCAN_CHUNK; i < end; ++i) {
+                if (statuses[i] == skip) continue;
+                count[keys[i]] += counts ? counts[i] : 1;
+                revenue[keys[i]] += values[i];
+            }
+            for (int g = 0; g < groups; ++g) {
+                partial[c * groups + g].count = count[g];
+                partial[c * groups + g].revenue = revenue[g];
+            }
+        });
+        vector<SalesRow> rows(groups);
+        for (size_t c = 0; c < chunks; ++c) {
+            for (int g = 0; g < groups; ++g) {
+                rows[g].count += partial[c * groups + g].count;
+                rows[g].revenue += partial[c * groups + g].revenue;
+            }
+        }
+        return rows;
+    }
+
+public:
+    void addOrder(const Order& o) {
+        orderStatus.push_back(o.getStatus());
+        deliveryType.push_back(o.getDeliveryType());
+        paymentMethod.push_back(o.getPaymentMethod());
+        orderTotal.push_back(o.getTotalCost());
+    }
+
+    void addLine(const OrderLine& line, OrderStatus status) {
+        lineCategory.push_back(line.product ? line.product->getCategory() : NUM_CATEGORIES);
+        lineStatus.push_back(status);
+        lineQuantity.push_back(line.quantity);
+        linePrice.push_back(line.price);
+    }
+
+    // The lines [first, first + count) were copied elsewhere in the buffer
+    // and no longer belong to any order
+    void dropLines(uint32_t first, uint32_t count) {
+        for (uint32_t i = first; i < first + count; ++i) {
+            lineQuantity[i] = 0;
+            linePrice[i] = 0.0;
+        }
+    }
+
+    // The order at slot, whose lines are o's, changed status
+    void setStatus(int slot, const Order& o) {
+        orderStatus[slot] = o.getStatus();
+        for (uint32_t i = o.getFirstLine(); i < o.getFirstLine() + o.getLineCount(); ++i)
+            lineStatus[i] = o.getStatus();
+    }
+
+    void reserveOrders(size_t count) {
+        orderStatus.reserve(count);
+        deliveryType.reserve(count);
+        paymentMethod.reserve(count);
+        orderTotal.reserve(count);
+    }
+
+    void reserveLines(size_t count) {
+        lineCategory.reserve(count);
+        lineStatus.reserve(count);
+        lineQuantity.reserve(count);
+        linePrice.reserve(count);
+    }
+
+    // Orders and revenue per ORDER_STATUS_NAMES entry
+    vector<SalesRow> byStatus(int workers) const {
+        return sumByGroup(orderStatus.data(), NUM_ORDER_STATUSES, orderStatus.data(), NUM_ORDER_STATUSES,
+                          NULL, orderTotal.data(), orderStatus.size(), workers);
+    }
+
+    // Orders and revenue per PAYMENT_METHOD_NAMES entry, cancelled orders left out
+    vector<SalesRow> byPaymentMethod(int workers) const {
+        return sumByGroup(paymentMethod.data(), NUM_PAYMENT_METHODS, orderStatus.data(), STATUS_CANCELLED,
+                          NULL, orderTotal.data(), orderStatus.size(), workers);
+    }
+
+    // Orders and revenue per DELIVERY_TYPE_NAMES entry, cancelled orders left out
+    vector<SalesRow> byDeliveryType(int workers) const {
+        return sumByGroup(deliveryType.data(), NUM_DELIVERY_TYPES, orderStatus.data(), STATUS_CANCELLED,
+                          NULL, orderTotal.data(), orderStatus.size(), workers);
+    }
+
+    // Units sold and line revenue per CATEGORY_NAMES entry, then the removed
+    // products. Lines of cancelled orders are left out; delivery charges are
+    // not part of any line.
+    vector<SalesRow> byCategory(int workers) const {
+        return sumByGroup(lineCategory.data(), NUM_SALES_CATEGORIES, lineStatus.data(), STATUS_CANCELLED,
+                          lineQuantity.data(), linePrice.data(), lineCategory.size(), workers);
+    }
+
+    void clear() {
+        orderStatus.clear();
+        deliveryType.clear();
+        paymentMethod.clear();
+        orderTotal.clear();
+        lineCategory.clear();
+        lineStatus.clear();
+        lineQuantity.clear();
+        linePrice.clear();
+    }
+};
+
+// Safe for concurrent use. The catalog (products and their indexes) is only
+// written while the shop is being built and is read without locks afterwards;
+// addProduct must not race with readers. Users and orders have one
+// reader-writer lock each, always taken users first, and the journal mutex
+// comes last. Neither table is sharded: a user slot indexes ordersByUser,
+// totalsByUser and the address index, and userIndex and allUsers grow as a
+// whole. Only registrations and address changes write the users table, and
+// a checkout to the address on file only reads it. commitJournal takes the
+// commit mutex holding none of them, and takes the journal mutex from under
+// it only briefly. A customer's cart is guarded by its customerLock, which
+// callers take before any of those. getOrderAt hands out references that are
+// only stable while the shop is used from one thread.
+class NTSHOP {
+    vector<Product*> allProducts;
+    IdIndex productIndex;  // product ID -> slot in allProducts
+    ProductSearchIndex searchIndex;  // name and sub-category words -> product slots
+    vector<int> productsByCategory[NUM_CATEGORIES];  // slots in allProducts, per CATEGORY_NAMES entry
+    PriceTable priceTable;  // base price and pricing rule per slot in allProducts
+    PriceIndex priceIndex;  // slots in allProducts by base price, per category and overall
+    vector<User*> allUsers;
+    NameIndex userIndex;  // username -> slot in allUsers
+    TrigramIndex addressIndex;  // customer address trigrams -> user slots
+    vector<Order> allOrders;
+    IdIndex orderIndex;  // order ID -> slot in allOrders
+    vector<OrderLine> orderLines;  // line items of every order, each order's lines contiguous
+    vector<vector<int> > ordersByUser;  // user slot -> slots of that user's orders in allOrders
+    vector<CustomerTotals> totalsByUser;  // user slot -> totals of that user's orders
+    SalesColumns salesColumns;  // allOrders and orderLines as the sales reports read them
+    int loadWorkers;  // threads that parse the text files and sum the sales reports
+    ofstream journal;
+    int journalFd;      // the journal file again, only for syncing it; -1 on Windows
+    int journalEvents;  // events appended since the last checkpoint
+    long long journalWritten;  // events appended since the shop opened
+    long long journalDurable;  // of those, how many are known to be on disk
+    long long journalSyncs;    // batches synced since the shop opened
+    bool committing;           // a thread is syncing a batch
+    int commitDelayUs;
+
+    mutable shared_mutex usersLock;   // allUsers, userIndex, addressIndex, customer addresses
+    mutable shared_mutex ordersLock;  // allOrders, orderIndex, orderLines, ordersByUser, totalsByUser, salesColumns, order statuses
+    mutex journalMutex;               // journal, journalEvents, journalWritten
+    mutable mutex commitMutex;        // journalDurable, journalSyncs, committing, commitDelayUs
+    condition_variable commitDone;
+    mutable mutex customerShards[CUSTOMER_LOCK_SHARDS];
+
+    // Each thread reuses its own buffer for product and order listings
+    static RenderBuffer& listingBuffer() {
+        static thread_local RenderBuffer buffer;
+        return buffer;
+    }
+
+public:
+    // Opens the saved shop. workers is how many threads parse the text files;
+    // 0 means one per core.
+    explicit NTSHOP(int workers = 0)
+        : loadWorkers(workers > 0 ? workers : max(1, (int)thread::hardware_concurrency())),
+          journalEvents(0), journalWritten(0), journalDurable(0), journalSyncs(0), committing(false),
+          commitDelayUs(DEFAULT_COMMIT_DELAY_US) {
+        // The text files are only read when there is no usable snapshot. A
+        // snapshot older than any of them is not used (see snapshotIsCurrent).
+        if (!loadSnapshot()) loadTextFiles();
+        journal.open(JOURNAL_FILE, ios::app);
+#ifndef _WIN32
+        journalFd = open(JOURNAL_FILE.c_str(), O_RDONLY);
+#else
+        journalFd = -1;  // the journal stream's flush is all Windows gets
+#endif
+        
+        // If no admin exists, create default admin
+        if (findUser("admin") == NULL) {
+            addUser(new Admin("admin", "admin123", this));
+        }
+        
+        // If no products exist, create default ones
+        if (allProducts.empty()) {
+            addDefaultProducts();
+        }
+    }
+
+    ~NTSHOP() {
+        saveData();  // Save all data before destruction
+#ifndef _WIN32
+        if (journalFd >= 0) close(journalFd);
+#endif
+        for (size_t i = 0; i < allProducts.size(); ++i) delete allProducts[i];
+        for (size_t i = 0; i < allUsers.size(); ++i) delete allUsers[i];
+    }
+
+    // Helper function to validate username
+    static bool isValidUsername(const string& username) {
+        if (username.length() < MIN_USERNAME_LENGTH || username.length() > MAX_USERNAME_LENGTH) {
+            return false;
+        }
+        // Check if username contains only alphanumeric characters
+        for (char c : username) {
+            if (!isalnum(c)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    // Helper function to validate password
+    static bool isValidPassword(const string& password) {
+        if (password.length() < MIN_PASSWORD_LENGTH || password.length() > MAX_PASSWORD_LENGTH) {
+            return false;
+        }
+        // Check if password contains at least one digit and one letter
+        bool hasDigit = false;
+        bool hasLetter = false;
+        for (char c : password) {
+            if (isdigit(c)) hasDigit = true;
+            if (isalpha(c)) hasLetter = true;
+        }
+        return hasDigit && hasLetter;
+    }
+    
+    // Helper function to validate account number
+    static bool isValidAccountNumber(const string& accNum) {
+        if (accNum.length() != ACCOUNT_NUMBER_LENGTH) {
+            return false;
+        }
+        // Check if account number contains only digits
+        for (char c : accNum) {
+            if (!isdigit(c)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void addDefaultProducts() {
+        // ========== FASHION PRODUCTS  ==========
+        addProduct(new FashionProduct(1, "Slim Fit Jeans", 3500.0, "Men's Clothing"));
+        addProduct(new FashionProduct(2, "Leather Handbag", 6800.0, "Women's Accessories"));
+        addProduct(new FashionProduct(3, "Cotton T-Shirt", 1200.0, "Men's Clothing"));
+        addProduct(new FashionProduct(4, "Summer Dress", 4500.0, "Women's Clothing"));
+        addProduct(new FashionProduct(5, "Leather Belt", 1500.0, "Accessories"));
+        addProduct(new FashionProduct(6, "Sports Shoes", 5500.0, "Footwear"));
+        addProduct(new FashionProduct(7, "Woolen Sweater", 3800.0, "Winter Wear"));
+        addProduct(new FashionProduct(8, "Formal Suit", 12000.0, "Men's Clothing"));
+        addProduct(new FashionProduct(9, "Evening Gown", 8500.0, "Women's Clothing"));
+        addProduct(new FashionProduct(10, "Running Shoes", 4200.0, "Footwear"));
+        addProduct(new FashionProduct(11, "Leather Jacket", 9500.0, "Outerwear"));
+        addProduct(new FashionProduct(12, "Casual Shirt", 1800.0, "Men's Clothing"));
+        addProduct(new FashionProduct(13, "Skirt", 2800.0, "Women's Clothing"));
+        addProduct(new FashionProduct(14, "Wrist Watch", 6500.0, "Accessories"));
+        addProduct(new FashionProduct(15, "Sunglasses", 2200.0, "Accessories"));
+        addProduct(new FashionProduct(16, "Backpack", 3200.0, "Bags"));
+        addProduct(new FashionProduct(17, "Swimwear", 2500.0, "Beachwear"));
         addProduct(new FashionProduct(18, "Tie Set", 1200.0, "Accessories"));
         addProduct(new FashionProduct(19, "Winter Gloves", 800.0, "Winter Wear"));
         addProduct(new FashionProduct(20, "Formal Shoes", 4800.0, "Footwear"));
@@ -493,55 +1884,130 @@ public:
         addProduct(new ElectronicsProduct(80, "Electric Kettle", 2800.0, "Home Appliances"));
     }
 
+    // Only while the shop is being built: catalog readers take no lock
     bool addProduct(Product* p) {
-        if (productCount >= MAX_PRODUCTS) return false;
-        allProducts[productCount++] = p;
+        // A duplicate ID keeps resolving to the first product, as the old scan did
+        productIndex.insert(p->getId(), (int)allProducts.size());
+        searchIndex.add((int)allProducts.size(), p->getName(), p->getSubCategory());
+        productsByCategory[p->getCategory()].push_back((int)allProducts.size());
+        priceTable.add(p);
+        priceIndex.add((int)allProducts.size(), p->getCategory(), p->getBasePrice());
+        allProducts.push_back(p);
         return true;
     }
 
     Product* getProductById(int id) const {
-        for (int i = 0; i < productCount; ++i)
-            if (allProducts[i]->getId() == id) return allProducts[i];
-        return NULL;
+        int slot = productIndex.find(id);
+        return slot >= 0 ? allProducts[slot] : NULL;
     }
 
-    void displayAllProductsByCategory(const string& cat) const {
-        bool found = false;
-        cout << "\n--- Products in " << cat << " ---" << endl;
-        for (int i = 0; i < productCount; ++i) {
-            if (allProducts[i]->getCategory() == cat) {
-                allProducts[i]->displayDetails();
-                found = true;
-            }
+    // Slot in allProducts of the product with this ID, or -1
+    int findProductSlot(int id) const { return productIndex.find(id); }
+
+    const PriceTable& getPriceTable() const { return priceTable; }
+
+    // Slots in allProducts of every product in cat, in insertion order
+    const vector<int>& getProductSlotsInCategory(Category cat) const {
+        return productsByCategory[cat];
+    }
+
+    void displayAllProductsByCategory(Category cat) const {
+        RenderBuffer& listing = listingBuffer();
+        listing << "\n--- Products in " << CATEGORY_NAMES[cat] << " ---\n";
+        if (productsByCategory[cat].empty()) {
+            listing << "No products found in this category.\n";
+        } else {
+            const vector<int>& slots = productsByCategory[cat];
+            for (size_t i = 0; i < slots.size(); ++i) allProducts[slots[i]]->renderDetails(listing);
         }
-        if (!found) cout << "No products found in this category." << endl;
-        cout << "--------------------------------\n" << endl;
+        listing << "--------------------------------\n\n";
+        listing.flushTo(cout);
     }
 
-    void displayAllProducts() const {
-        cout << "\n--- All Products (" << productCount << " products) ---" << endl;
-        for (int i = 0; i < productCount; ++i)
-            allProducts[i]->displayDetails();
-        cout << "--------------------------------\n" << endl;
+    // Products whose name or sub-category contains every word of query
+    vector<Product*> searchProducts(const string& query) const {
+        vector<int> slots = searchIndex.search(query);
+        vector<Product*> found;
+        found.reserve(slots.size());
+        for (size_t i = 0; i < slots.size(); ++i) found.push_back(allProducts[slots[i]]);
+        return found;
+    }
+
+    void displaySearchResults(const string& query) const {
+        RenderBuffer& listing = listingBuffer();
+        vector<Product*> found = searchProducts(query);
+        listing << "\n--- Search Results for \"" << query << "\" (" << found.size() << " products) ---\n";
+        for (size_t i = 0; i < found.size() && i < (size_t)MAX_SEARCH_RESULTS; ++i)
+            found[i]->renderDetails(listing);
+        if (found.empty()) listing << "No products match your search.\n";
+        else if (found.size() > (size_t)MAX_SEARCH_RESULTS)
+            listing << "... and " << found.size() - MAX_SEARCH_RESULTS << " more. Add words to narrow the search.\n";
+        listing << "--------------------------------\n\n";
+        listing.flushTo(cout);
+    }
+
+    // How many products of category (or ANY_CATEGORY) cost between minPrice
+    // and maxPrice, inclusive
+    int countProductsInPriceRange(int category, double minPrice, double maxPrice) const {
+        return (int)priceIndex.count(category, minPrice, maxPrice);
+    }
+
+    // Products [offset, offset + count) of that price band, cheapest first
+    // or, if descending, dearest first
+    vector<Product*> getProductsByPrice(int category, double minPrice, double maxPrice, bool descending,
+                                        size_t offset, size_t count) const {
+        vector<int> slots = priceIndex.slotsByPrice(category, minPrice, maxPrice, descending, offset, count);
+        vector<Product*> found;
+        found.reserve(slots.size());
+        for (size_t i = 0; i < slots.size(); ++i) found.push_back(allProducts[slots[i]]);
+        return found;
+    }
+
+    // Lists one page of a price band, in one write
+    void displayProductsByPrice(int category, double minPrice, double maxPrice, bool descending,
+                                size_t offset, size_t count) const {
+        RenderBuffer& listing = listingBuffer();
+        vector<Product*> page = getProductsByPrice(category, minPrice, maxPrice, descending, offset, count);
+        listing << "\n--- " << (category == ANY_CATEGORY ? string("All Products") : CATEGORY_NAMES[category])
+                << " from PKR " << minPrice;
+        if (maxPrice < HUGE_VAL) listing << " to PKR " << maxPrice;
+        listing << ", " << (descending ? "highest" : "lowest") << " price first ("
+                << countProductsInPriceRange(category, minPrice, maxPrice) << " products) ---\n";
+        for (size_t i = 0; i < page.size(); ++i) page[i]->renderDetails(listing);
+        if (page.empty()) listing << "No products in this price range.\n";
+        listing << "--------------------------------\n\n";
+        listing.flushTo(cout);
+    }
+
+    // The count cheapest (or, if dearest, most expensive) products of every category
+    void displayPriceExtremes(bool dearest, size_t count) const {
+        RenderBuffer& listing = listingBuffer();
+        for (int c = 0; c < NUM_CATEGORIES; ++c) {
+            listing << "\n--- " << (dearest ? "Most Expensive in " : "Cheapest in ") << CATEGORY_NAMES[c] << " ---\n";
+            vector<Product*> top = getProductsByPrice(c, 0.0, HUGE_VAL, dearest, 0, count);
+            for (size_t i = 0; i < top.size(); ++i) top[i]->renderDetails(listing);
+            if (top.empty()) listing << "No products found in this category.\n";
+        }
+        listing << "--------------------------------\n\n";
+        listing.flushTo(cout);
+    }
+
+    // Lists the products in slots [offset, offset + count), in one write
+    void displayAllProducts(size_t offset = 0, size_t count = SIZE_MAX) const {
+        RenderBuffer& listing = listingBuffer();
+        size_t end = offset + min(count, allProducts.size() - min(offset, allProducts.size()));
+        listing << "\n--- All Products (" << allProducts.size() << " products) ---\n";
+        for (size_t i = offset; i < end; ++i)
+            allProducts[i]->renderDetails(listing);
+        listing << "--------------------------------\n\n";
+        listing.flushTo(cout);
     }
 
     void displayCategorySummary() const {
         cout << "\n--- Product Categories Summary ---" << endl;
-        int fashionCount = 0, educationCount = 0, automobileCount = 0, electronicsCount = 0;
-        
-        for (int i = 0; i < productCount; ++i) {
-            string cat = allProducts[i]->getCategory();
-            if (cat == "Fashion") fashionCount++;
-            else if (cat == "Education") educationCount++;
-            else if (cat == "Automobiles") automobileCount++;
-            else if (cat == "Electronics") electronicsCount++;
-        }
-        
-        cout << "Fashion: " << fashionCount << " products" << endl;
-        cout << "Education: " << educationCount << " products" << endl;
-        cout << "Automobiles: " << automobileCount << " products" << endl;
-        cout << "Electronics: " << electronicsCount << " products" << endl;
-        cout << "Total: " << productCount << " products" << endl;
+        for (int c = 0; c < NUM_CATEGORIES; ++c)
+            cout << CATEGORY_NAMES[c] << ": " << productsByCategory[c].size() << " products" << endl;
+        cout << "Total: " << allProducts.size() << " products" << endl;
         cout << "--------------------------------\n" << endl;
     }
 
@@ -558,207 +2024,1125 @@ public:
             return false;
         }
         
-        if (findUser(u) != NULL) {
-            cout << "Username already exists! Please choose a different username." << endl;
+        Customer* c = new Customer(u, p, this);
+        bool checkpoint;
+        {
+            unique_lock<shared_mutex> users(usersLock);
+            if (userIndex.find(u) >= 0) {
+                users.unlock();
+                delete c;
+                cout << "Username already exists! Please choose a different username." << endl;
+                return false;
+            }
+            insertUser(c);
+            lock_guard<mutex> lock(journalMutex);
+            journal << "USER|" << c->toFileString();
+            checkpoint = endJournalEvent();
+        }
+        if (checkpoint) checkpointIfDue();
+        return true;
+    }
+
+    void addUser(User* u) {
+        unique_lock<shared_mutex> lock(usersLock);
+        insertUser(u);
+    }
+
+    // Adds u to the user table and indexes. Caller holds usersLock exclusively.
+    void insertUser(User* u) {
+        // A duplicate name keeps resolving to the first user, as the old scan did
+        userIndex.insert(&u->getUsername(), (int)allUsers.size());
+        if (dynamic_cast<Customer*>(u)) addressIndex.add((int)allUsers.size(), u->getAddress());
+        allUsers.push_back(u);
+        ordersByUser.push_back(vector<int>());
+        totalsByUser.push_back(CustomerTotals());
+    }
+
+    // Changes a customer's address and keeps the address index in step.
+    // Checkout calls this with the address usually already on file, which
+    // only needs the users lock shared.
+    void updateCustomerAddress(Customer* c, const string& address) {
+        {
+            shared_lock<shared_mutex> lock(usersLock);
+            if (c->getAddress() == address) return;
+        }
+        unique_lock<shared_mutex> lock(usersLock);
+        int slot = userIndex.find(c->getUsername());
+        if (slot < 0 || allUsers[slot] != c) {
+            // Only a hand-edited file can hold two users with one name
+            slot = (int)(find(allUsers.begin(), allUsers.end(), (User*)c) - allUsers.begin());
+            if (slot == (int)allUsers.size()) return;
+        }
+        if (c->getAddress() == address) return;
+        addressIndex.remove(slot, c->getAddress());
+        c->setAddress(address);
+        addressIndex.add(slot, address);
+        if (addressIndex.needsRebuild()) rebuildAddressIndex();
+    }
+
+    // Caller holds usersLock exclusively (or is still loading)
+    void rebuildAddressIndex() {
+        addressIndex.clear();
+        for (size_t i = 0; i < allUsers.size(); ++i)
+            if (dynamic_cast<Customer*>(allUsers[i])) addressIndex.add((int)i, allUsers[i]->getAddress());
+    }
+
+    Customer* findCustomer(const string& uname) const {
+        return dynamic_cast<Customer*>(findUser(uname));
+    }
+
+    // Customers whose address contains key, in registration order
+    vector<Customer*> findCustomersByAddress(const string& key) const {
+        vector<Customer*> found;
+        if (key.empty()) return found;
+        shared_lock<shared_mutex> lock(usersLock);
+        if (key.size() < TrigramIndex::MIN_QUERY_LENGTH) {
+            // Too short for the trigram index
+            for (size_t i = 0; i < allUsers.size(); ++i) {
+                Customer* c = dynamic_cast<Customer*>(allUsers[i]);
+                if (c && c->getAddress().find(key) != string::npos) found.push_back(c);
+            }
+            return found;
+        }
+        vector<int> slots = addressIndex.candidates(key);
+        for (size_t i = 0; i < slots.size(); ++i) {
+            User* u = allUsers[slots[i]];
+            if (u->getAddress().find(key) != string::npos) found.push_back((Customer*)u);
+        }
+        return found;
+    }
+
+    User* findUser(const string& uname) const {
+        shared_lock<shared_mutex> lock(usersLock);
+        int slot = userIndex.find(uname);
+        return slot >= 0 ? allUsers[slot] : NULL;
+    }
+
+    // Builds a new order for the cart straight into the order table and
+    // journals it. Apart from the tables growing, nothing is allocated.
+    // The order is not durable until commitJournal returns.
+    // Returns the new order's ID. The ID and the line prices are worked out
+    // before any lock is taken; the order lock is held only for the append.
+    int placeOrder(const string& uname, const string& addr, const CartItem cart[], int cartCount,
+                   PaymentMethod pMethod, DeliveryType dType, double baseCost) {
+        int count = cartCount < MAX_ORDER_ITEMS ? cartCount : MAX_ORDER_ITEMS;
+        double lineTotals[MAX_CART_ITEMS];
+        priceCart(cart, count, lineTotals);
+        int id = Order::allocateId();
+
+        bool checkpoint;
+        {
+            shared_lock<shared_mutex> users(usersLock);
+            unique_lock<shared_mutex> orders(ordersLock);
+            allOrders.emplace_back();
+            Order& order = allOrders.back();
+            order.initialize(id, uname, addr, (uint32_t)orderLines.size(), (uint32_t)count, pMethod, dType, baseCost);
+            for (int i = 0; i < count; ++i) {
+                Product* p = cart[i].getProduct();
+                OrderLine line = { p, p ? p->getId() : 0, cart[i].getQuantity(), lineTotals[i] };
+                pushOrderLine(line, STATUS_PLACED);
+            }
+            indexOrder((int)allOrders.size() - 1);
+
+            // Events reach the journal in the order the changes were made
+            lock_guard<mutex> lock(journalMutex);
+            journal << "ORDER|";
+            order.writeFileString(journal);
+            journal << "|";
+            order.writeLines(journal, linesOf(order));
+            checkpoint = endJournalEvent();
+        }
+        if (checkpoint) checkpointIfDue();
+        return id;
+    }
+
+    // The lines of an order held by this shop
+    const OrderLine* linesOf(const Order& o) const { return orderLines.data() + o.getFirstLine(); }
+
+    // Appends a line of an order in the given status to the line buffer
+    void pushOrderLine(const OrderLine& line, OrderStatus status) {
+        orderLines.push_back(line);
+        salesColumns.addLine(line, status);
+    }
+
+    // Adds a line to the order at slot. Lines arrive order by order, so this
+    // is an append; if the order's lines are not at the end of the buffer they
+    // are moved there first (only a hand-edited file gets there).
+    void appendOrderLine(int slot, const OrderLine& line) {
+        Order& o = allOrders[slot];
+        uint32_t end = (uint32_t)orderLines.size();
+        if (o.getLineCount() == 0) {
+            o.setLines(end, 0);
+        } else if (o.getFirstLine() + o.getLineCount() != end) {
+            for (uint32_t i = 0; i < o.getLineCount(); ++i) {
+                OrderLine moved = orderLines[o.getFirstLine() + i];
+                pushOrderLine(moved, o.getStatus());
+            }
+            salesColumns.dropLines(o.getFirstLine(), o.getLineCount());
+            o.setLines(end, o.getLineCount());
+        }
+        pushOrderLine(line, o.getStatus());
+        o.setLines(o.getFirstLine(), o.getLineCount() + 1);
+    }
+
+    // Lists the orders at the given slots, in one write
+    void displayOrders(const vector<int>& slots) const {
+        RenderBuffer& listing = listingBuffer();
+        shared_lock<shared_mutex> lock(ordersLock);
+        for (size_t i = 0; i < slots.size(); ++i)
+            allOrders[slots[i]].renderOrder(listing, linesOf(allOrders[slots[i]]));
+        listing.flushTo(cout);
+    }
+
+    // Indexes the order at the given slot by ID, files it under its
+    // customer's order list and adds it to the customer's totals and the
+    // sales columns. Orders are indexed in slot order. A duplicate ID keeps
+    // resolving to the first order. Caller holds usersLock shared and
+    // ordersLock exclusively (or is loading).
+    void indexOrder(int orderSlot) {
+        const Order& order = allOrders[orderSlot];
+        orderIndex.insert(order.getId(), orderSlot);
+        salesColumns.addOrder(order);
+        int userSlot = userIndex.find(order.getUsername());
+        if (userSlot < 0) return;
+        ordersByUser[userSlot].push_back(orderSlot);
+        CustomerTotals& totals = totalsByUser[userSlot];
+        totals.lastOrderId = order.getId();
+        if (order.getStatus() != STATUS_CANCELLED) {
+            totals.orders++;
+            totals.spent += order.getTotalCost();
+        }
+    }
+
+    // Sets the status of the order at slot and moves it into or out of its
+    // customer's totals if it is cancelled or restored. Caller holds usersLock
+    // shared and ordersLock exclusively (or is loading).
+    void applyOrderStatus(int slot, OrderStatus status) {
+        Order& order = allOrders[slot];
+        bool wasCounted = order.getStatus() != STATUS_CANCELLED;
+        bool counted = status != STATUS_CANCELLED;
+        order.setStatus(status);
+        salesColumns.setStatus(slot, order);
+        int userSlot = userIndex.find(order.getUsername());
+        if (wasCounted == counted || userSlot < 0) return;
+        CustomerTotals& totals = totalsByUser[userSlot];
+        totals.orders += counted ? 1 : -1;
+        totals.spent += counted ? order.getTotalCost() : -order.getTotalCost();
+    }
+
+    // The totals of uname's orders; all zero for an unknown user
+    CustomerTotals getCustomerTotals(const string& uname) const {
+        shared_lock<shared_mutex> users(usersLock);
+        shared_lock<shared_mutex> orders(ordersLock);
+        int userSlot = userIndex.find(uname);
+        return userSlot >= 0 ? totalsByUser[userSlot] : CustomerTotals();
+    }
+
+    // Slots in allUsers of the count customers who have spent the most, in
+    // descending order of spend. Customers with no spend are left out.
+    vector<int> topCustomers(size_t count) const {
+        shared_lock<shared_mutex> users(usersLock);
+        shared_lock<shared_mutex> orders(ordersLock);
+        vector<int> slots;
+        for (size_t i = 0; i < totalsByUser.size(); ++i)
+            if (totalsByUser[i].spent > 0.0) slots.push_back((int)i);
+        count = min(count, slots.size());
+        // Equal spend goes to whoever registered first
+        partial_sort(slots.begin(), slots.begin() + count, slots.end(), [this](int a, int b) {
+            if (totalsByUser[a].spent != totalsByUser[b].spent) return totalsByUser[a].spent > totalsByUser[b].spent;
+            return a < b;
+        });
+        slots.resize(count);
+        return slots;
+    }
+
+    void displayTopCustomers(size_t count) const {
+        vector<int> top = topCustomers(count);
+        RenderBuffer& listing = listingBuffer();
+        listing << "\n--- Top Customers by Amount Shopped ---\n";
+        {
+            shared_lock<shared_mutex> users(usersLock);
+            shared_lock<shared_mutex> orders(ordersLock);
+            for (size_t i = 0; i < top.size(); ++i) {
+                const CustomerTotals& totals = totalsByUser[top[i]];
+                listing << (int)(i + 1) << ". " << allUsers[top[i]]->getUsername() << " - PKR " << totals.spent
+                        << " over " << totals.orders << " orders (last order " << totals.lastOrderId << ")\n";
+            }
+        }
+        if (top.empty()) listing << "No customers have shopped yet.\n";
+        listing.flushTo(cout);
+    }
+
+    // Sales reports, summed over the sales columns on workers threads; 0
+    // means as many as load the text files
+    vector<SalesRow> salesByStatus(int workers = 0) const {
+        shared_lock<shared_mutex> lock(ordersLock);
+        return salesColumns.byStatus(workers > 0 ? workers : loadWorkers);
+    }
+    vector<SalesRow> salesByPaymentMethod(int workers = 0) const {
+        shared_lock<shared_mutex> lock(ordersLock);
+        return salesColumns.byPaymentMethod(workers > 0 ? workers : loadWorkers);
+    }
+    vector<SalesRow> salesByDeliveryType(int workers = 0) const {
+        shared_lock<shared_mutex> lock(ordersLock);
+        return salesColumns.byDeliveryType(workers > 0 ? workers : loadWorkers);
+    }
+    vector<SalesRow> salesByCategory(int workers = 0) const {
+        shared_lock<shared_mutex> lock(ordersLock);
+        return salesColumns.byCategory(workers > 0 ? workers : loadWorkers);
+    }
+
+    // Prints one report: a row per group named in names, the total, then
+    // note if there is one. unit is what a row's count counts.
+    static void displaySalesReport(const string& title, const vector<SalesRow>& rows, const string names[],
+                                   const char* unit, const char* note) {
+        RenderBuffer& listing = listingBuffer();
+        SalesRow total;
+        listing << "\n--- Sales by " << title << " ---\n";
+        for (size_t g = 0; g < rows.size(); ++g) {
+            listing << names[g] << ": " << rows[g].count << ' ' << unit << ", PKR " << rows[g].revenue << '\n';
+            total.count += rows[g].count;
+            total.revenue += rows[g].revenue;
+        }
+        listing << "Total: " << total.count << ' ' << unit << ", PKR " << total.revenue << '\n';
+        if (note) listing << note << '\n';
+        listing << "--------------------------------\n";
+        listing.flushTo(cout);
+    }
+
+    void displaySalesByCategory() const {
+        static const string names[NUM_SALES_CATEGORIES] = {
+            CATEGORY_NAMES[0], CATEGORY_NAMES[1], CATEGORY_NAMES[2], CATEGORY_NAMES[3], "Removed products" };
+        displaySalesReport("Category", salesByCategory(), names, "units",
+                           "Cancelled orders and delivery charges are not included.");
+    }
+    void displaySalesByPaymentMethod() const {
+        displaySalesReport("Payment Method", salesByPaymentMethod(), PAYMENT_METHOD_NAMES, "orders",
+                           "Cancelled orders are not included.");
+    }
+    void displaySalesByDeliveryType() const {
+        displaySalesReport("Delivery Type", salesByDeliveryType(), DELIVERY_TYPE_NAMES, "orders",
+                           "Cancelled orders are not included.");
+    }
+    void displaySalesByStatus() const {
+        displaySalesReport("Order Status", salesByStatus(), ORDER_STATUS_NAMES, "orders", NULL);
+    }
+
+    // Slots in allOrders of every order placed by uname, oldest first. A copy,
+    // since a checkout may grow the list while the caller uses it.
+    vector<int> getOrderSlotsOf(const string& uname) const {
+        shared_lock<shared_mutex> users(usersLock);
+        shared_lock<shared_mutex> orders(ordersLock);
+        int userSlot = userIndex.find(uname);
+        return userSlot >= 0 ? ordersByUser[userSlot] : vector<int>();
+    }
+
+    // Slot in allOrders of the order with this ID, or -1
+    int findOrderSlot(int id) const {
+        shared_lock<shared_mutex> lock(ordersLock);
+        return orderIndex.find(id);
+    }
+
+    // Moves the order with this ID from one status to another in one step, so
+    // two sessions cannot both act on the same placed order. Returns false if
+    // there is no such order or it is not in status from. If found is given,
+    // it receives the status the order had, or -1 if there is no such order.
+    bool changeOrderStatus(int id, OrderStatus from, OrderStatus to, int* found = NULL) {
+        bool checkpoint;
+        {
+            shared_lock<shared_mutex> users(usersLock);
+            unique_lock<shared_mutex> lock(ordersLock);
+            int slot = orderIndex.find(id);
+            if (found) *found = slot >= 0 ? allOrders[slot].getStatus() : -1;
+            if (slot < 0 || allOrders[slot].getStatus() != from) return false;
+            checkpoint = setOrderStatus(slot, to);
+        }
+        if (checkpoint) checkpointIfDue();
+        return true;
+    }
+
+    // Caller holds usersLock shared and ordersLock exclusively. Returns
+    // whether a checkpoint is due.
+    bool setOrderStatus(int slot, OrderStatus status) {
+        applyOrderStatus(slot, status);
+        lock_guard<mutex> lock(journalMutex);
+        journal << "STATUS|" << allOrders[slot].getId() << "|" << ORDER_STATUS_NAMES[status];
+        return endJournalEvent();
+    }
+
+    int getOrderCount() const {
+        shared_lock<shared_mutex> lock(ordersLock);
+        return (int)allOrders.size();
+    }
+    const Order& getOrderAt(int idx) const { return allOrders[idx]; }
+    Order& getOrderAt(int idx) { return allOrders[idx]; }
+
+    // Lists the orders in slots [offset, offset + count), in one write
+    void displayAllOrders(size_t offset = 0, size_t count = SIZE_MAX) const {
+        RenderBuffer& listing = listingBuffer();
+        shared_lock<shared_mutex> lock(ordersLock);
+        if (allOrders.empty()) { cout << "\nNo orders placed yet." << endl; return; }
+        size_t end = offset + min(count, allOrders.size() - min(offset, allOrders.size()));
+        for (size_t i = offset; i < end; ++i) allOrders[i].renderOrder(listing, linesOf(allOrders[i]));
+        listing.flushTo(cout);
+    }
+
+    int countOrdersWithStatus(OrderStatus status) const {
+        shared_lock<shared_mutex> lock(ordersLock);
+        int count = 0;
+        for (size_t i = 0; i < allOrders.size(); ++i)
+            if (allOrders[i].getStatus() == status) count++;
+        return count;
+    }
+
+    // Lists delivered orders [offset, offset + count) in placement order, in one write
+    void displayDeliveredOrders(size_t offset = 0, size_t count = SIZE_MAX) const {
+        RenderBuffer& listing = listingBuffer();
+        shared_lock<shared_mutex> lock(ordersLock);
+        listing << "\n--- Delivered Orders ---\n";
+        bool found = false;
+        size_t seen = 0, last = count > SIZE_MAX - offset ? SIZE_MAX : offset + count;
+        for (size_t i = 0; i < allOrders.size() && seen < last; ++i) {
+            if (allOrders[i].getStatus() == STATUS_DELIVERED) {
+                found = true;
+                if (seen++ < offset) continue;
+                allOrders[i].renderOrder(listing, linesOf(allOrders[i]));
+            }
+        }
+        if (!found) listing << "No delivered orders found.\n";
+        listing.flushTo(cout);
+    }
+
+    User** getUsersArray() { return allUsers.data(); }
+    int getUserCount() const {
+        shared_lock<shared_mutex> lock(usersLock);
+        return (int)allUsers.size();
+    }
+    User* getUserAt(int slot) const {
+        shared_lock<shared_mutex> lock(usersLock);
+        return allUsers[slot];
+    }
+
+    // Guards the cart of the customer with this username
+    mutex& customerLock(const string& uname) const {
+        return customerShards[NameIndex::hashOf(uname) % CUSTOMER_LOCK_SHARDS];
+    }
+    Product** getProductArray() { return allProducts.data(); }
+    int getProductCount() const { return (int)allProducts.size(); }
+    
+    // Writes every data file in full and empties the journal they now cover.
+    // Changes wait until it is done.
+    void saveData() {
+        shared_lock<shared_mutex> users(usersLock);
+        shared_lock<shared_mutex> orders(ordersLock);
+        lock_guard<mutex> lock(journalMutex);
+        writeAllFiles();
+    }
+
+    // Folds the journal into the data files if enough events have piled up.
+    // Several threads may find a checkpoint due; only the first one saves.
+    void checkpointIfDue() {
+        shared_lock<shared_mutex> users(usersLock);
+        shared_lock<shared_mutex> orders(ordersLock);
+        lock_guard<mutex> lock(journalMutex);
+        if (checkpointDue()) writeAllFiles();
+    }
+
+    bool checkpointDue() const {
+        return journalEvents >= JOURNAL_CHECKPOINT_EVENTS &&
+               journalEvents >= (int)(allUsers.size() + allOrders.size());
+    }
+
+    // Caller holds usersLock and ordersLock (shared is enough) and journalMutex.
+    // Each file is on disk before it replaces the old one, so the journal can
+    // be emptied once all of them are saved. If any fails, the journal is kept
+    // so that the next start still replays the changes it holds.
+    void writeAllFiles() {
+        bool saved = saveUsers();
+        saved = saveProducts() && saved;
+        saved = saveOrders() && saved;
+        saved = saveOrderItems() && saved;
+        saved = saveSnapshot() && saved;
+        if (!saved) {
+            cout << "Error: Data files not saved, keeping the journal." << endl;
+            return;
+        }
+        journal.close();
+        journal.open(JOURNAL_FILE, ios::trunc);
+        journalEvents = 0;
+    }
+
+    // Ends the event just written to the journal, which records one change.
+    // Events are written straight into the stream so that logging one builds
+    // no temporary strings, and stay buffered until commitJournal. The data
+    // files are only rewritten once enough changes have piled up: a true
+    // result asks the caller to call checkpointIfDue once it has released its
+    // locks. Caller holds journalMutex.
+    bool endJournalEvent() {
+        journal << '\n';
+        journalEvents++;
+        journalWritten++;
+        return journalEvents >= JOURNAL_CHECKPOINT_EVENTS;
+    }
+
+    // Returns once every change journaled before the call is on disk. Changes
+    // are synced in batches: callers arriving while a sync runs wait for it
+    // and then go out together in the next one, so concurrent checkouts share
+    // one write and one sync. The thread leading a batch first waits up to
+    // the commit delay for more changes to join. Tell a user a change is done
+    // only after this.
+    void commitJournal() {
+        long long target;
+        {
+            lock_guard<mutex> lock(journalMutex);
+            target = journalWritten;
+        }
+        unique_lock<mutex> lock(commitMutex);
+        while (journalDurable < target) {
+            if (committing) {
+                commitDone.wait(lock);
+                continue;
+            }
+            committing = true;
+            int delay = commitDelayUs;
+            lock.unlock();
+            if (delay > 0) this_thread::sleep_for(chrono::microseconds(delay));
+            long long batchEnd;
+            {
+                lock_guard<mutex> journalLock(journalMutex);
+                journal.flush();
+                batchEnd = journalWritten;
+            }
+            // Changes keep being journaled while the disk catches up
+            syncDescriptor(journalFd);
+            lock.lock();
+            journalDurable = batchEnd;
+            journalSyncs++;
+            committing = false;
+            commitDone.notify_all();
+        }
+    }
+
+    void setCommitDelay(int microseconds) {
+        lock_guard<mutex> lock(commitMutex);
+        commitDelayUs = max(0, microseconds);
+    }
+
+    long long getJournalSyncCount() const {
+        lock_guard<mutex> lock(commitMutex);
+        return journalSyncs;
+    }
+    
+    bool saveUsers() {
+        string tempFile = USERS_FILE + ".tmp";
+        ofstream outFile(tempFile);
+        if (!outFile) {
+            cout << "Error: Could not save users to file!" << endl;
+            return false;
+        }
+        for (size_t i = 0; i < allUsers.size(); ++i) {
+            outFile << allUsers[i]->toFileString() << endl;
+        }
+        if (!replaceFile(outFile, tempFile, USERS_FILE)) {
+            cout << "Error: Could not save users to file!" << endl;
+            return false;
+        }
+        return true;
+    }
+    
+    bool saveProducts() {
+        string tempFile = PRODUCTS_FILE + ".tmp";
+        ofstream outFile(tempFile);
+        if (!outFile) {
+            cout << "Error: Could not save products to file!" << endl;
+            return false;
+        }
+        for (size_t i = 0; i < allProducts.size(); ++i) {
+            outFile << allProducts[i]->toFileString() << endl;
+        }
+        if (!replaceFile(outFile, tempFile, PRODUCTS_FILE)) {
+            cout << "Error: Could not save products to file!" << endl;
+            return false;
+        }
+        return true;
+    }
+    
+    bool saveOrders() {
+        string tempFile = ORDERS_FILE + ".tmp";
+        ofstream outFile(tempFile);
+        if (!outFile) {
+            cout << "Error: Could not save orders to file!" << endl;
+            return false;
+        }
+        for (size_t i = 0; i < allOrders.size(); ++i) {
+            outFile << allOrders[i].toFileString() << endl;
+        }
+        if (!replaceFile(outFile, tempFile, ORDERS_FILE)) {
+            cout << "Error: Could not save orders to file!" << endl;
+            return false;
+        }
+        return true;
+    }
+    
+    // Line records of every order, grouped by order in allOrders order
+    vector<OrderLineRecord> collectOrderLines() const {
+        vector<OrderLineRecord> records;
+        records.reserve(orderLines.size());
+        for (size_t i = 0; i < allOrders.size(); ++i) {
+            const OrderLine* lines = linesOf(allOrders[i]);
+            for (uint32_t j = 0; j < allOrders[i].getLineCount(); ++j) {
+                OrderLineRecord r = { allOrders[i].getId(), lines[j].productId, lines[j].quantity, 0, lines[j].price };
+                records.push_back(r);
+            }
+        }
+        return records;
+    }
+
+    bool saveOrderItems() {
+        string tempFile = ORDER_ITEMS_FILE + ".tmp";
+        ofstream outFile(tempFile, ios::binary | ios::trunc);
+        if (!outFile) {
+            cout << "Error: Could not save order items to file!" << endl;
+            return false;
+        }
+        vector<OrderLineRecord> records = collectOrderLines();
+        outFile.write((const char*)records.data(), records.size() * sizeof(OrderLineRecord));
+        if (!replaceFile(outFile, tempFile, ORDER_ITEMS_FILE)) {
+            cout << "Error: Could not save order items to file!" << endl;
             return false;
         }
+        return true;
+    }
+
+    void loadOrderItems() {
+        MappedFile file(ORDER_ITEMS_FILE);
+        // A partly written record at the end is dropped
+        orderLines.reserve(file.size() / sizeof(OrderLineRecord));
+        salesColumns.reserveLines(file.size() / sizeof(OrderLineRecord));
+        attachOrderLines((const OrderLineRecord*)file.data(), file.size() / sizeof(OrderLineRecord));
+    }
+
+    OrderLine makeOrderLine(int productId, int quantity, double price) const {
+        OrderLine line = { getProductById(productId), productId, quantity, price };
+        return line;
+    }
+
+    // Gives each line record to the order it belongs to. Records arrive grouped
+    // by order, so the owner is only looked up when the order ID changes.
+    void attachOrderLines(const OrderLineRecord* records, size_t count) {
+        int cursor = -1;
+        for (size_t i = 0; i < count; ++i) {
+            const OrderLineRecord& r = records[i];
+            if (cursor < 0 || allOrders[cursor].getId() != r.orderId) {
+                cursor = orderIndex.find(r.orderId);
+                if (cursor < 0) continue;  // order no longer exists
+            }
+            appendOrderLine(cursor, makeOrderLine(r.productId, r.quantity, r.price));
+        }
+    }
+
+    // Reads the productId:quantity:price list written by Order::writeLines
+    // into the order at slot
+    void parseOrderLines(string_view text, int slot) {
+        while (!text.empty()) {
+            size_t comma = text.find(',');
+            string_view entry = text.substr(0, comma);
+            text = comma == string_view::npos ? string_view() : text.substr(comma + 1);
+
+            string_view tokens[3];
+            int productId, quantity;
+            double price;
+            if (splitFields(entry, ':', tokens, 3) == 3 && parseInt(tokens[0], productId) &&
+                parseInt(tokens[1], quantity) && parseDouble(tokens[2], price)) {
+                appendOrderLine(slot, makeOrderLine(productId, quantity, price));
+            }
+        }
+    }
+
+    // Rough record count of a data file from its size, used to reserve
+    // storage up front instead of growing one record at a time
+    static size_t estimateRecords(long long fileBytes, size_t bytesPerRecord) {
+        return fileBytes > 0 ? (size_t)fileBytes / bytesPerRecord + 1 : 0;
+    }
+
+    // Reads the three text files at once. Users and products load on threads
+    // of their own while this one parses the orders. Orders are filed only
+    // once the users are in, since each goes under its customer, and their
+    // line items only once the products are in. Each loader leaves its
+    // warning in a string of its own, printed once all of them are done, so
+    // the messages come out whole and in the same order every time.
+    void loadTextFiles() {
+        string usersWarning, productsWarning, ordersWarning;
+        thread users(&NTSHOP::loadUsers, this, &usersWarning);
+        thread products(&NTSHOP::loadProducts, this, &productsWarning);
+        loadOrders(users, products, ordersWarning);
+        cout << usersWarning << productsWarning << ordersWarning << flush;
+    }
+
+    // Parses a text file in newline-aligned chunks on the loader threads and
+    // hands each chunk's records to merge on this thread, in file order. The
+    // next wave of chunks is parsed while one wave is merged, so at most two
+    // waves of parsed records are held at a time. merge empties what it takes.
+    template <class Records, class Parse, class Merge>
+    void parseInChunks(const MappedFile& file, Parse parse, Merge merge) const {
+        string_view text(file.data(), file.size());
+        vector<string_view> chunks = splitAtLines(text, text.size() / LOAD_CHUNK_BYTES + 1);
+        size_t wave = (size_t)loadWorkers;
+        vector<Records> merging(wave), parsing(wave);
+        auto parseWave = [&](size_t first, vector<Records>& out) {
+            runInParallel(min(wave, chunks.size() - first), loadWorkers,
+                          [&](size_t i) { parse(chunks[first + i], out[i]); });
+        };
+
+        if (chunks.empty()) return;
+        parseWave(0, merging);
+        for (size_t first = 0; first < chunks.size(); first += wave) {
+            thread ahead;
+            if (first + wave < chunks.size()) ahead = thread(parseWave, first + wave, ref(parsing));
+            for (size_t i = 0; i < min(wave, chunks.size() - first); ++i) merge(merging[i]);
+            if (ahead.joinable()) ahead.join();
+            merging.swap(parsing);
+        }
+    }
+
+    void loadUsers(string* warning) {
+        MappedFile file(USERS_FILE);
+        if (!file.isOpen()) {
+            *warning = "No existing users file found. Starting fresh.\n";
+            replayJournal(true);  // changes made before the first save
+            return;
+        }
         
-        if (userCount >= MAX_USERS) {
-            cout << "Maximum user limit reached! Cannot register new user." << endl;
+        size_t expected = allUsers.size() + estimateRecords(file.size(), 40);
+        allUsers.reserve(expected);
+        ordersByUser.reserve(expected);
+        totalsByUser.reserve(expected);
+        userIndex.reserve((int)expected);
+
+        parseInChunks<vector<User*> >(file, [this](string_view text, vector<User*>& users) {
+            string_view line;
+            while (takeLine(text, line)) {
+                if (line.empty()) continue;
+                User* user = parseUser(line);
+                if (user) users.push_back(user);
+            }
+        }, [this](vector<User*>& users) {
+            unique_lock<shared_mutex> lock(usersLock);
+            for (size_t i = 0; i < users.size(); ++i) insertUser(users[i]);
+            users.clear();
+        });
+        replayJournal(true);
+    }
+
+    // A new user from a users.txt record, or NULL if its type is unknown
+    User* parseUser(string_view record) {
+        string_view type = record.substr(0, record.find('|'));
+
+        User* user = NULL;
+        if (type == "ADMIN") {
+            user = new Admin("", "", this);
+        } else if (type == "CUSTOMER") {
+            user = new Customer("", "", this);
+        }
+        if (user) user->fromFileString(record);
+        return user;
+    }
+
+    User* addUserFromFileString(string_view record) {
+        User* user = parseUser(record);
+        if (user) addUser(user);
+        return user;
+    }
+
+    // Keeps the order just parsed into the back of allOrders, or drops it if
+    // an order with the same ID is already present. The journal replay parses
+    // each record in place there instead of building it elsewhere and copying it in.
+    bool keepLoadedOrder() {
+        int slot = (int)allOrders.size() - 1;
+        int id = allOrders[slot].getId();
+        if (orderIndex.find(id) >= 0) {
+            allOrders.pop_back();
             return false;
         }
-        
-        allUsers[userCount++] = new Customer(u, p, this);
+        indexOrder(slot);
+
+        // Update nextOrderId to avoid duplicates using the static method
+        Order::updateNextOrderId(id);
         return true;
     }
 
-    User* findUser(const string& uname) const {
-        for (int i = 0; i < userCount; ++i)
-            if (allUsers[i]->getUsername() == uname) return allUsers[i];
-        return NULL;
+    // Re-applies the changes logged since the last checkpoint: registrations
+    // when loading users, placed orders and status changes when loading orders.
+    // Replaying an event the data files already contain is harmless, so a crash
+    // between a checkpoint and the journal truncation loses nothing.
+    void replayJournal(bool users) {
+        LineReader reader(JOURNAL_FILE);
+        string_view line;
+        while (reader.next(line)) {
+            size_t bar = line.find('|');
+            if (bar == string_view::npos) continue;
+            string_view kind = line.substr(0, bar);
+            string_view record = line.substr(bar + 1);
+
+            if (users && kind == "USER") {
+                string_view tokens[2];  // type, username
+                splitFields(record, '|', tokens, 2);
+                if (findUser(string(tokens[1])) == NULL) addUserFromFileString(record);
+            } else if (!users && kind == "ORDER") {
+                allOrders.emplace_back();
+                if (!allOrders.back().fromFileString(record)) {  // torn write at the end of the journal
+                    allOrders.pop_back();
+                    continue;
+                }
+                if (!keepLoadedOrder()) continue;
+                // Checkout stores the delivery address as the customer's address
+                const Order& order = allOrders.back();
+                Customer* customer = findCustomer(order.getUsername());
+                if (customer) updateCustomerAddress(customer, order.getAddress());
+                string_view tokens[10];  // the nine order fields, then its line items
+                splitFields(record, '|', tokens, 10);
+                parseOrderLines(tokens[9], (int)allOrders.size() - 1);
+            } else if (!users && kind == "STATUS") {
+                string_view tokens[2];  // order ID, status
+                int id;
+                if (splitFields(record, '|', tokens, 2) < 2 || !parseInt(tokens[0], id)) continue;
+                int status = lookupName(tokens[1], ORDER_STATUS_NAMES, NUM_ORDER_STATUSES);
+                if (status < 0) continue;
+                int slot = findOrderSlot(id);
+                if (slot >= 0) applyOrderStatus(slot, (OrderStatus)status);
+            }
+        }
     }
+    
+    void loadProducts(string* warning) {
+        MappedFile file(PRODUCTS_FILE);
+        if (!file.isOpen()) {
+            *warning = "No existing products file found. Starting fresh.\n";
+            return;
+        }
+        
+        size_t expected = allProducts.size() + estimateRecords(file.size(), 60);
+        allProducts.reserve(expected);
+        productIndex.reserve((int)expected);
 
-    bool addOrder(const Order& o) {
-        if (orderCount >= MAX_ORDERS) return false;
-        allOrders[orderCount++] = o;
-        cout << "\n\n********************************************************" << endl;
-        cout << "    Order Placed Successfully! Order ID: " << allOrders[orderCount-1].getId() << endl;
-        cout << "********************************************************\n" << endl;
-        return true;
+        parseInChunks<vector<Product*> >(file, [](string_view text, vector<Product*>& products) {
+            string_view line;
+            while (takeLine(text, line)) {
+                Product* p = parseProduct(line);
+                if (p) products.push_back(p);
+            }
+        }, [this](vector<Product*>& products) {
+            for (size_t i = 0; i < products.size(); ++i) addProduct(products[i]);
+            products.clear();
+        });
     }
 
-    int getOrderCount() const { return orderCount; }
-    const Order& getOrderAt(int idx) const { return allOrders[idx]; }
-    Order& getOrderAt(int idx) { return allOrders[idx]; }
+    // A new product from a products.txt line, or NULL if it is malformed
+    static Product* parseProduct(string_view line) {
+        // TYPE|id|name|category|price|subCategory
+        string_view tokens[6];
+        if (splitFields(line, '|', tokens, 6) < 6) return NULL;
 
-    void displayAllOrders() const {
-        if (orderCount == 0) { cout << "\nNo orders placed yet." << endl; return; }
-        for (int i = 0; i < orderCount; ++i) allOrders[i].displayOrder();
+        int id;
+        double price;
+        if (!parseInt(tokens[1], id) || !parseDouble(tokens[4], price)) return NULL;
+
+        int type = lookupName(tokens[0], PRODUCT_TYPES, NUM_PRODUCT_TYPES);
+        return type >= 0 ? createProduct(type, id, string(tokens[2]), price, string(tokens[5])) : NULL;
     }
 
-    void displayDeliveredOrders() const {
-        cout << "\n--- Delivered Orders ---" << endl;
-        bool found = false;
-        for (int i = 0; i < orderCount; ++i) {
-            if (allOrders[i].getStatus() == "Delivered") {
-                allOrders[i].displayOrder();
-                found = true;
-            }
+    // type is an index into PRODUCT_TYPES
+    static Product* createProduct(int type, int id, const string& name, double price, const string& subCategory) {
+        switch (type) {
+            case 0: return new FashionProduct(id, name, price, subCategory);
+            case 1: return new EducationProduct(id, name, price, subCategory);
+            case 2: return new AutomobileProduct(id, name, price, subCategory);
+            case 3: return new ElectronicsProduct(id, name, price, subCategory);
+            default: return NULL;
         }
-        if (!found) cout << "No delivered orders found." << endl;
     }
 
-    User** getUsersArray() { return allUsers; }
-    int getUserCount() const { return userCount; }
-    Product** getProductArray() { return allProducts; }
-    int getProductCount() const { return productCount; }
-    
-    void saveData() {
-        saveUsers();
-        saveProducts();
-        saveOrders();
+    static int productTypeCode(const Product* p) {
+        string type = p->getType();
+        for (int t = 0; t < NUM_PRODUCT_TYPES; ++t)
+            if (type == PRODUCT_TYPES[t]) return t;
+        return -1;
     }
-    
-    void saveUsers() {
-        ofstream outFile(USERS_FILE);
-        if (!outFile) {
-            cout << "Error: Could not save users to file!" << endl;
-            return;
+
+    // Writes shop.snap next to the text files. It goes to a temporary file
+    // first so a crash mid-write never leaves a half-written snapshot behind.
+    bool saveSnapshot() {
+        SnapshotHeapWriter heap;
+        vector<ProductRecord> products(allProducts.size());
+        for (size_t i = 0; i < allProducts.size(); ++i) {
+            products[i].id = allProducts[i]->getId();
+            products[i].type = productTypeCode(allProducts[i]);
+            products[i].price = allProducts[i]->getBasePrice();
+            products[i].name = heap.add(allProducts[i]->getName());
+            products[i].subCategory = heap.add(allProducts[i]->getSubCategory());
         }
-        for (int i = 0; i < userCount; ++i) {
-            outFile << allUsers[i]->toFileString() << endl;
+        vector<UserRecord> users(allUsers.size());
+        for (size_t i = 0; i < allUsers.size(); ++i) {
+            users[i].type = allUsers[i]->getUserType() == "ADMIN" ? 0 : 1;
+            users[i].reserved = 0;
+            users[i].username = heap.add(allUsers[i]->getUsername());
+            users[i].password = heap.add(allUsers[i]->getPassword());
+            users[i].address = heap.add(allUsers[i]->getAddress());
         }
-        outFile.close();
-    }
-    
-    void saveProducts() {
-        ofstream outFile(PRODUCTS_FILE);
+        vector<OrderRecord> orders(allOrders.size());
+        for (size_t i = 0; i < allOrders.size(); ++i) {
+            const Order& o = allOrders[i];
+            orders[i].id = o.getId();
+            orders[i].itemsCount = o.getItemsCount();
+            orders[i].totalCost = o.getTotalCost();
+            orders[i].deliveryCharge = o.getDeliveryCharge();
+            orders[i].customer = heap.add(o.getUsername());
+            orders[i].address = heap.add(o.getAddress());
+            orders[i].deliveryType = heap.add(o.getDeliveryTypeName());
+            orders[i].paymentMethod = heap.add(o.getPaymentMethodName());
+            orders[i].status = heap.add(o.getStatusName());
+        }
+
+        SnapshotHeader header;
+        memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_VERSION;
+        header.productCount = (uint32_t)products.size();
+        header.userCount = (uint32_t)users.size();
+        header.orderCount = (uint32_t)orders.size();
+        vector<OrderLineRecord> lines = collectOrderLines();
+        header.lineCount = (uint32_t)lines.size();
+        header.reserved = 0;
+        header.heapSize = heap.bytes().size();
+
+        string tempFile = SNAPSHOT_FILE + ".tmp";
+        ofstream outFile(tempFile, ios::binary | ios::trunc);
         if (!outFile) {
-            cout << "Error: Could not save products to file!" << endl;
-            return;
+            cout << "Error: Could not save snapshot to file!" << endl;
+            return false;
         }
-        for (int i = 0; i < productCount; ++i) {
-            outFile << allProducts[i]->toFileString() << endl;
+        outFile.write((const char*)&header, sizeof(header));
+        outFile.write((const char*)products.data(), products.size() * sizeof(ProductRecord));
+        outFile.write((const char*)users.data(), users.size() * sizeof(UserRecord));
+        outFile.write((const char*)orders.data(), orders.size() * sizeof(OrderRecord));
+        outFile.write((const char*)lines.data(), lines.size() * sizeof(OrderLineRecord));
+        outFile.write(heap.bytes().data(), heap.bytes().size());
+        if (!replaceFile(outFile, tempFile, SNAPSHOT_FILE)) {
+            cout << "Error: Could not save snapshot to file!" << endl;
+            return false;
         }
-        outFile.close();
+        return true;
     }
-    
-    void saveOrders() {
-        ofstream outFile(ORDERS_FILE);
-        if (!outFile) {
-            cout << "Error: Could not save orders to file!" << endl;
-            return;
-        }
-        for (int i = 0; i < orderCount; ++i) {
-            outFile << allOrders[i].toFileString() << endl;
+
+    // Whether shop.snap is at least as new as every text data file. Saves
+    // always write it last, so a text file with a later time was edited or
+    // restored by hand since, and the text files are then the ones to load.
+    static bool snapshotIsCurrent() {
+        error_code error;
+        filesystem::file_time_type saved = filesystem::last_write_time(SNAPSHOT_FILE, error);
+        if (error) return false;
+        const string* sources[] = {&USERS_FILE, &PRODUCTS_FILE, &ORDERS_FILE, &ORDER_ITEMS_FILE};
+        for (const string* path : sources) {
+            filesystem::file_time_type written = filesystem::last_write_time(*path, error);
+            if (!error && written > saved) return false;
         }
-        outFile.close();
+        return true;
     }
-    
-    void loadUsers() {
-        ifstream inFile(USERS_FILE);
-        if (!inFile) {
-            cout << "No existing users file found. Starting fresh." << endl;
-            return;
+
+    // Loads products, users, orders and their lines from shop.snap, then replays the
+    // journal. Returns false, leaving the shop empty, if there is no snapshot,
+    // it is damaged or from another version (including a product or user type
+    // it does not know), or a text file is newer; the text files are used then.
+    bool loadSnapshot() {
+        MappedFile file(SNAPSHOT_FILE);
+        if (file.size() < sizeof(SnapshotHeader)) return false;
+        if (!snapshotIsCurrent()) {
+            cout << "Data files changed since the snapshot was saved. Loading the text files instead." << endl;
+            return false;
         }
-        
-        char line[256];  // Fixed size array for line reading
-        while (inFile.getline(line, 256) && userCount < MAX_USERS) {
-            string strLine(line);
-            if (strLine.empty()) continue;
-            
-            stringstream ss(strLine);
-            string type;
-            getline(ss, type, '|');
-            
-            if (type == "ADMIN") {
-                Admin* admin = new Admin("", "", this);
-                admin->fromFileString(strLine);
-                allUsers[userCount++] = admin;
-            } else if (type == "CUSTOMER") {
-                Customer* customer = new Customer("", "", this);
-                customer->fromFileString(strLine);
-                allUsers[userCount++] = customer;
+
+        SnapshotHeader header;
+        memcpy(&header, file.data(), sizeof(header));
+        if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != SNAPSHOT_VERSION) {
+            return false;
+        }
+        uint64_t recordBytes = header.productCount * (uint64_t)sizeof(ProductRecord)
+                             + header.userCount * (uint64_t)sizeof(UserRecord)
+                             + header.orderCount * (uint64_t)sizeof(OrderRecord)
+                             + header.lineCount * (uint64_t)sizeof(OrderLineRecord);
+        if (sizeof(SnapshotHeader) + recordBytes + header.heapSize != file.size()) return false;
+
+        const char* cursor = file.data() + sizeof(SnapshotHeader);
+        const ProductRecord* products = (const ProductRecord*)cursor;
+        cursor += header.productCount * sizeof(ProductRecord);
+        const UserRecord* users = (const UserRecord*)cursor;
+        cursor += header.userCount * sizeof(UserRecord);
+        const OrderRecord* orders = (const OrderRecord*)cursor;
+        cursor += header.orderCount * sizeof(OrderRecord);
+        const OrderLineRecord* lines = (const OrderLineRecord*)cursor;
+        cursor += header.lineCount * sizeof(OrderLineRecord);
+        const char* heap = cursor;
+        uint64_t heapSize = header.heapSize;
+
+        bool valid = true;
+        auto view = [&](const SnapshotString& ref) {
+            if ((uint64_t)ref.offset + ref.length > heapSize) {
+                valid = false;
+                return string_view();
+            }
+            return string_view(heap + ref.offset, ref.length);
+        };
+        auto text = [&](const SnapshotString& ref) { return string(view(ref)); };
+        // Position of the referenced string in names, or 0 (and invalid) if absent
+        auto code = [&](const SnapshotString& ref, const string names[], int count) {
+            if ((uint64_t)ref.offset + ref.length > heapSize) {
+                valid = false;
+                return 0;
+            }
+            int c = lookupName(string_view(heap + ref.offset, ref.length), names, count);
+            if (c < 0) valid = false;
+            return c < 0 ? 0 : c;
+        };
+
+        allProducts.reserve(header.productCount);
+        productIndex.reserve((int)header.productCount);
+        for (uint32_t i = 0; i < header.productCount && valid; ++i) {
+            const ProductRecord& r = products[i];
+            Product* p = createProduct(r.type, r.id, text(r.name), r.price, text(r.subCategory));
+            if (p) addProduct(p);
+            else valid = false;  // a type code this version does not know
+        }
+
+        allUsers.reserve(header.userCount);
+        ordersByUser.reserve(header.userCount);
+        totalsByUser.reserve(header.userCount);
+        userIndex.reserve((int)header.userCount);
+        for (uint32_t i = 0; i < header.userCount && valid; ++i) {
+            const UserRecord& r = users[i];
+            if (r.type < 0 || r.type > 1) {
+                valid = false;
+                break;
             }
+            User* u;
+            if (r.type == 0) u = new Admin(text(r.username), text(r.password), this);
+            else u = new Customer(text(r.username), text(r.password), this);
+            u->setAddress(text(r.address));
+            addUser(u);
         }
-        inFile.close();
+
+        allOrders.resize(header.orderCount);
+        orderIndex.reserve((int)header.orderCount);
+        salesColumns.reserveOrders(header.orderCount);
+        for (uint32_t i = 0; i < header.orderCount && valid; ++i) {
+            const OrderRecord& r = orders[i];
+            allOrders[i].restore(r.id, text(r.customer), view(r.address), r.itemsCount, r.totalCost,
+                                 (DeliveryType)code(r.deliveryType, DELIVERY_TYPE_NAMES, NUM_DELIVERY_TYPES),
+                                 r.deliveryCharge,
+                                 (PaymentMethod)code(r.paymentMethod, PAYMENT_METHOD_NAMES, NUM_PAYMENT_METHODS),
+                                 (OrderStatus)code(r.status, ORDER_STATUS_NAMES, NUM_ORDER_STATUSES));
+            indexOrder((int)i);
+            Order::updateNextOrderId(r.id);
+        }
+        orderLines.reserve(header.lineCount);
+        salesColumns.reserveLines(header.lineCount);
+        attachOrderLines(lines, header.lineCount);
+
+        if (!valid) {
+            cout << "Snapshot file is damaged. Loading the text files instead." << endl;
+            clearAll();
+            return false;
+        }
+        replayJournal(true);
+        replayJournal(false);
+        return true;
+    }
+
+    // Drops everything loaded so far (used when a snapshot turns out damaged)
+    void clearAll() {
+        for (size_t i = 0; i < allProducts.size(); ++i) delete allProducts[i];
+        for (size_t i = 0; i < allUsers.size(); ++i) delete allUsers[i];
+        allProducts.clear();
+        allUsers.clear();
+        allOrders.clear();
+        orderLines.clear();
+        ordersByUser.clear();
+        totalsByUser.clear();
+        salesColumns.clear();
+        productIndex.clear();
+        orderIndex.clear();
+        searchIndex.clear();
+        addressIndex.clear();
+        for (int c = 0; c < NUM_CATEGORIES; ++c) productsByCategory[c].clear();
+        priceTable.clear();
+        priceIndex.clear();
+        userIndex = NameIndex();
     }
     
-    void loadProducts() {
-        ifstream inFile(PRODUCTS_FILE);
-        if (!inFile) {
-            cout << "No existing products file found. Starting fresh." << endl;
+    // Runs while usersLoading and productsLoading fill in the users and the
+    // catalog, and waits for each of them before it needs it. Both have
+    // finished when this returns.
+    void loadOrders(thread& usersLoading, thread& productsLoading, string& warning) {
+        MappedFile file(ORDERS_FILE);
+        if (!file.isOpen()) {
+            warning = "No existing orders file found. Starting fresh.\n";
+            usersLoading.join();
+            productsLoading.join();
+            replayJournal(false);
             return;
         }
         
-        char line[256];
-        while (inFile.getline(line, 256) && productCount < MAX_PRODUCTS) {
-            string strLine(line);
-            if (strLine.empty()) continue;
-            
-            stringstream ss(strLine);
-            string tokens[6];
-            int tokenCount = 0;
-            string token;
-            
-            while (getline(ss, token, '|') && tokenCount < 6) {
-                tokens[tokenCount++] = token;
+        size_t expected = allOrders.size() + estimateRecords(file.size(), 80);
+        allOrders.reserve(expected);
+        orderIndex.reserve((int)expected);
+        salesColumns.reserveOrders(expected);
+
+        parseInChunks<vector<Order> >(file, [](string_view text, vector<Order>& orders) {
+            string_view line;
+            while (takeLine(text, line)) {
+                if (line.empty()) continue;
+                orders.emplace_back();
+                if (!orders.back().fromFileString(line)) orders.pop_back();
             }
-            
-            if (tokenCount < 6) continue;
-            
-            int id = stoi(tokens[1]);
-            double price = stod(tokens[4]);
-            string name = tokens[2];
-            string subCategory = tokens[5];
-            
-            if (tokens[0] == "FASHION") {
-                allProducts[productCount++] = new FashionProduct(id, name, price, subCategory);
-            } else if (tokens[0] == "EDUCATION") {
-                allProducts[productCount++] = new EducationProduct(id, name, price, subCategory);
-            } else if (tokens[0] == "AUTOMOBILE") {
-                allProducts[productCount++] = new AutomobileProduct(id, name, price, subCategory);
-            } else if (tokens[0] == "ELECTRONICS") {
-                allProducts[productCount++] = new ElectronicsProduct(id, name, price, subCategory);
+        }, [&](vector<Order>& orders) {
+            if (usersLoading.joinable()) usersLoading.join();
+            for (size_t i = 0; i < orders.size(); ++i) {
+                if (orderIndex.find(orders[i].getId()) >= 0) continue;  // a repeated ID keeps the first order
+                allOrders.push_back(move(orders[i]));
+                indexOrder((int)allOrders.size() - 1);
+                Order::updateNextOrderId(allOrders.back().getId());
             }
-        }
-        inFile.close();
+            orders.clear();
+        });
+        if (usersLoading.joinable()) usersLoading.join();
+        productsLoading.join();
+        loadOrderItems();
+        replayJournal(false);
     }
-    
-    void loadOrders() {
-        ifstream inFile(ORDERS_FILE);
-        if (!inFile) {
-            cout << "No existing orders file found. Starting fresh." << endl;
+};
+
+// Shows page 1 of a listing of total rows, then lets the user jump between
+// pages until they enter 0. show(offset, count) prints one page.
+template <class ShowPage>
+void browsePages(int total, int perPage, ShowPage show) {
+    int pages = max(1, (total + perPage - 1) / perPage);
+    int page = 1;
+    show(0, (size_t)perPage);
+    while (pages > 1) {
+        cout << "Page " << page << " of " << pages << ". Enter page number (0 to go back): ";
+        int next;
+        if (!(cin >> next)) {
+            cin.clear(); cin.ignore(10000, '\n');
             return;
         }
-        
-        char line[256];
-        while (inFile.getline(line, 256) && orderCount < MAX_ORDERS) {
-            string strLine(line);
-            if (strLine.empty()) continue;
-            
-            Order order;
-            order.fromFileString(strLine);
-            
-            // Check if order ID already exists
-            bool exists = false;
-            for (int i = 0; i < orderCount; i++) {
-                if (allOrders[i].getId() == order.getId()) {
-                    exists = true;
-                    break;
-                }
-            }
-            
-            if (!exists) {
-                allOrders[orderCount++] = order;
-                
-                // Update nextOrderId to avoid duplicates using the static method
-                Order::updateNextOrderId(order.getId());
-            }
+        if (next == 0) return;
+        if (next < 1 || next > pages) {
+            cout << "No such page." << endl;
+            continue;
         }
-        inFile.close();
+        page = next;
+        show((size_t)(page - 1) * perPage, (size_t)perPage);
     }
-};
+}
 
 bool Customer::addToCart(Product* p, int q) {
     if (!p || q <= 0) return false;
@@ -773,13 +3157,13 @@ void Customer::viewCart() const {
         return;
     }
     cout << "\n--- Your Shopping Cart ---" << endl;
-    double total = 0.0;
+    double lineTotals[MAX_CART_ITEMS];
+    double total = priceCart(shoppingCart, cartCount, lineTotals);
     for (int i = 0; i < cartCount; ++i) {
         const CartItem& item = shoppingCart[i];
         cout << (i + 1) << ". " << item.getProduct()->getName()
              << " x " << item.getQuantity()
-             << " | Price: PKR " << fixed << setprecision(2) << item.getTotalPrice() << endl;
-        total += item.getTotalPrice();
+             << " | Price: PKR " << fixed << setprecision(2) << lineTotals[i] << endl;
     }
     cout << "--------------------------------" << endl;
     cout << "Subtotal: PKR " << fixed << setprecision(2) << total << endl;
@@ -787,9 +3171,8 @@ void Customer::viewCart() const {
 }
 
 double Customer::calculateCartTotal() const {
-    double total = 0.0;
-    for (int i = 0; i < cartCount; ++i) total += shoppingCart[i].getTotalPrice();
-    return total;
+    double lineTotals[MAX_CART_ITEMS];
+    return priceCart(shoppingCart, cartCount, lineTotals);
 }
 
 void Customer::clearCart() {
@@ -816,15 +3199,15 @@ void Customer::checkout() {
     cout << "Enter your full delivery address: ";
     cin.ignore();
     getline(cin, tempAddress);
-    this->address = tempAddress;
+    shopSystem->updateCustomerAddress(this, tempAddress);
 
     int paymentChoice;
-    string paymentMethod;
+    PaymentMethod paymentMethod;
     cout << "\nSelect Payment Method (1 for Advance, 2 for Cash on Delivery): ";
     cin >> paymentChoice;
 
     if (paymentChoice == 1) {
-        paymentMethod = "Advance Payment";
+        paymentMethod = PAYMENT_ADVANCE;
         string accountName, accountNumber;
         cout << "Enter Account Name: ";
         cin.ignore();
@@ -845,12 +3228,11 @@ void Customer::checkout() {
         }
         cout << "Payment details secured for advance payment." << endl;
     } else {
-        paymentMethod = "Cash on Delivery (COD)";
+        paymentMethod = PAYMENT_COD;
     }
 
     int deliveryChoice;
-    string deliveryType;
-    double baseTotal = calculateCartTotal();
+    DeliveryType deliveryType;
     cout << "\nSelect Delivery Type:" << endl;
     cout << "1. Normal Delivery (5 days, No extra charge)" << endl;
     cout << "2. Urgent Delivery (3 days, PKR 500 extra charge)" << endl;
@@ -858,16 +3240,16 @@ void Customer::checkout() {
     cin >> deliveryChoice;
 
     if (deliveryChoice == 2) {
-        deliveryType = "Urgent";
+        deliveryType = DELIVERY_URGENT;
         cout << "Urgent Delivery selected (PKR 500 added to total)." << endl;
     } else {
-        deliveryType = "Normal";
+        deliveryType = DELIVERY_NORMAL;
     }
 
     cout << "\n\n--- Order Summary ---" << endl;
     viewCart();
-    cout << "Payment: " << paymentMethod << endl;
-    cout << "Delivery: " << deliveryType << endl;
+    cout << "Payment: " << PAYMENT_METHOD_NAMES[paymentMethod] << endl;
+    cout << "Delivery: " << DELIVERY_TYPE_NAMES[deliveryType] << endl;
 
     char confirm;
     cout << "Proceed with placing order? (y/n): ";
@@ -878,29 +3260,96 @@ void Customer::checkout() {
         return;
     }
 
-    Order newOrder;
-    newOrder.initialize(this->username, this->address, shoppingCart, cartCount, paymentMethod, deliveryType, baseTotal);
-
-    if (shopSystem->addOrder(newOrder)) {
-        clearCart();
-        shopSystem->saveData();  // Save data after successful order
-    } else {
+    if (placeCartOrder(tempAddress, paymentMethod, deliveryType) == 0) {
         cout << "Failed to add order to system." << endl;
     }
 }
 
+// Places an order for everything in the cart and empties it. Returns the new
+// order's ID, or 0 if the cart is empty.
+int Customer::placeCartOrder(const string& deliveryAddress, PaymentMethod payment, DeliveryType delivery) {
+    if (cartCount == 0) return 0;
+    shopSystem->updateCustomerAddress(this, deliveryAddress);
+    int id = shopSystem->placeOrder(this->username, this->address, shoppingCart, cartCount,
+                                    payment, delivery, calculateCartTotal());
+    clearCart();
+    shopSystem->commitJournal();
+
+    cout << "\n\n********************************************************" << endl;
+    cout << "    Order Placed Successfully! Order ID: " << id << endl;
+    cout << "********************************************************\n" << endl;
+    return id;
+}
+
 void Customer::viewOrderHistory() const {
     cout << "\n--- Your Order History ---" << endl;
-    bool found = false;
-    int oc = shopSystem->getOrderCount();
-    for (int i = 0; i < oc; ++i) {
-        const Order& o = shopSystem->getOrderAt(i);
-        if (o.getUsername() == this->username) {
-            o.displayOrder();
-            found = true;
+    vector<int> mine = shopSystem->getOrderSlotsOf(this->username);
+    shopSystem->displayOrders(mine);
+    if (mine.empty()) cout << "You have no orders yet." << endl;
+}
+
+// Asks for a product ID and quantity after a product listing
+void Customer::promptAddToCart() {
+    int productId, quantity;
+    cout << "Enter Product ID to add to cart (0 to skip): ";
+    if (!(cin >> productId)) {
+        cin.clear(); cin.ignore(10000, '\n'); return;
+    }
+    if (productId == 0) return;
+
+    Product* selectedProduct = shopSystem->getProductById(productId);
+    if (selectedProduct) {
+        cout << "Enter quantity: ";
+        if (!(cin >> quantity) || quantity <= 0) {
+            cin.clear(); cin.ignore(10000, '\n');
+            cout << "Invalid quantity. Skipped." << endl;
+            return;
+        }
+        if (addToCart(selectedProduct, quantity)) {
+            cout << " Added " << quantity << " x " << selectedProduct->getName() << " to cart." << endl;
+        } else {
+            cout << "Failed to add item to cart (cart full)." << endl;
         }
+    } else {
+        cout << " Invalid Product ID." << endl;
     }
-    if (!found) cout << "You have no orders yet." << endl;
+}
+
+// Asks for a category and a price range, then pages through the products in
+// it sorted by price
+void Customer::browseByPrice() {
+    int catChoice, order;
+    double minPrice, maxPrice;
+    cout << "\n--- Select Category ---" << endl;
+    cout << "0: All Categories\n1: Fashion\n2: Education\n3: Automobiles\n4: Electronics\nYour choice: ";
+    if (!(cin >> catChoice) || catChoice < 0 || catChoice > NUM_CATEGORIES) {
+        cin.clear(); cin.ignore(10000, '\n');
+        cout << "Invalid category." << endl;
+        return;
+    }
+    cout << "Lowest price (PKR): ";
+    if (!(cin >> minPrice)) minPrice = -1.0;
+    cout << "Highest price (PKR, 0 for no limit): ";
+    if (!(cin >> maxPrice)) maxPrice = -1.0;
+    if (maxPrice == 0.0) maxPrice = HUGE_VAL;
+    if (minPrice < 0.0 || maxPrice < minPrice) {
+        cin.clear(); cin.ignore(10000, '\n');
+        cout << "Invalid price range." << endl;
+        return;
+    }
+    cout << "1. Lowest Price First\n2. Highest Price First\nYour choice: ";
+    if (!(cin >> order) || order < 1 || order > 2) {
+        cin.clear(); cin.ignore(10000, '\n');
+        cout << "Invalid option." << endl;
+        return;
+    }
+
+    int category = catChoice == 0 ? ANY_CATEGORY : catChoice - 1;
+    browsePages(shopSystem->countProductsInPriceRange(category, minPrice, maxPrice), PRODUCTS_PER_PAGE,
+                [&](size_t offset, size_t count) {
+                    shopSystem->displayProductsByPrice(category, minPrice, maxPrice, order == 2, offset, count);
+                });
+    promptAddToCart();
 }
 
 void Customer::startSession() {
@@ -912,79 +3361,33 @@ void Customer::startSession() {
         cout << "3. View Category Summary" << endl;
         cout << "4. View Cart and Checkout" << endl;
         cout << "5. View Order History " << endl;
-        cout << "6. Logout" << endl;
+        cout << "6. Search Products" << endl;
+        cout << "7. Browse Products by Price" << endl;
+        cout << "8. Cheapest and Most Expensive Products" << endl;
+        cout << "9. Logout" << endl;
         cout << "Enter choice: ";
         if (!(cin >> choice)) {
             cin.clear(); cin.ignore(10000, '\n');
             cout << "Invalid input. Please try again." << endl;
             continue;
         }
-        if (choice == 6) break;
+        if (choice == 9) break;
 
         if (choice == 1) {
             int catChoice;
-            string catName;
             cout << "\n--- Select Category ---" << endl;
             cout << "1: Fashion\n2: Education\n3: Automobiles\n4: Electronics\nYour choice: ";
             cin >> catChoice;
-            switch (catChoice) {
-                case 1: catName = "Fashion"; break;
-                case 2: catName = "Education"; break;
-                case 3: catName = "Automobiles"; break;
-                case 4: catName = "Electronics"; break;
-                default: cout << "Invalid category." << endl; continue;
-            }
-            shopSystem->displayAllProductsByCategory(catName);
-
-            int productId, quantity;
-            cout << "Enter Product ID to add to cart (0 to skip): ";
-            if (!(cin >> productId)) {
-                cin.clear(); cin.ignore(10000, '\n'); continue;
-            }
-            if (productId == 0) continue;
-
-            Product* selectedProduct = shopSystem->getProductById(productId);
-            if (selectedProduct) {
-                cout << "Enter quantity: ";
-                if (!(cin >> quantity) || quantity <= 0) {
-                    cin.clear(); cin.ignore(10000, '\n');
-                    cout << "Invalid quantity. Skipped." << endl;
-                    continue;
-                }
-                if (addToCart(selectedProduct, quantity)) {
-                    cout << " Added " << quantity << " x " << selectedProduct->getName() << " to cart." << endl;
-                } else {
-                    cout << "Failed to add item to cart (cart full)." << endl;
-                }
-            } else {
-                cout << " Invalid Product ID." << endl;
+            if (catChoice < 1 || catChoice > NUM_CATEGORIES) {
+                cout << "Invalid category." << endl;
+                continue;
             }
+            shopSystem->displayAllProductsByCategory((Category)(catChoice - 1));
+            promptAddToCart();
         } else if (choice == 2) {
-            shopSystem->displayAllProducts();
-            
-            int productId, quantity;
-            cout << "Enter Product ID to add to cart (0 to skip): ";
-            if (!(cin >> productId)) {
-                cin.clear(); cin.ignore(10000, '\n'); continue;
-            }
-            if (productId == 0) continue;
-
-            Product* selectedProduct = shopSystem->getProductById(productId);
-            if (selectedProduct) {
-                cout << "Enter quantity: ";
-                if (!(cin >> quantity) || quantity <= 0) {
-                    cin.clear(); cin.ignore(10000, '\n');
-                    cout << "Invalid quantity. Skipped." << endl;
-                    continue;
-                }
-                if (addToCart(selectedProduct, quantity)) {
-                    cout << " Added " << quantity << " x " << selectedProduct->getName() << " to cart." << endl;
-                } else {
-                    cout << "Failed to add item to cart (cart full)." << endl;
-                }
-            } else {
-                cout << " Invalid Product ID." << endl;
-            }
+            browsePages(shopSystem->getProductCount(), PRODUCTS_PER_PAGE,
+                        [this](size_t offset, size_t count) { shopSystem->displayAllProducts(offset, count); });
+            promptAddToCart();
         } else if (choice == 3) {
             shopSystem->displayCategorySummary();
         } else if (choice == 4) {
@@ -997,6 +3400,25 @@ void Customer::startSession() {
             }
         } else if (choice == 5) {
             viewOrderHistory();
+        } else if (choice == 6) {
+            string query;
+            cout << "Enter keywords (e.g. leather jacket): ";
+            cin.ignore();
+            getline(cin, query);
+            shopSystem->displaySearchResults(query);
+            promptAddToCart();
+        } else if (choice == 7) {
+            browseByPrice();
+        } else if (choice == 8) {
+            int order;
+            cout << "1. Cheapest\n2. Most Expensive\nYour choice: ";
+            if (!(cin >> order) || order < 1 || order > 2) {
+                cin.clear(); cin.ignore(10000, '\n');
+                cout << "Invalid option." << endl;
+                continue;
+            }
+            shopSystem->displayPriceExtremes(order == 2, PRICE_EXTREMES_SHOWN);
+            promptAddToCart();
         } else {
             cout << "Invalid option." << endl;
         }
@@ -1004,7 +3426,8 @@ void Customer::startSession() {
 }
 
 void Admin::viewOrders() const {
-    shopSystem->displayAllOrders();
+    browsePages(shopSystem->getOrderCount(), ORDERS_PER_PAGE,
+                [this](size_t offset, size_t count) { shopSystem->displayAllOrders(offset, count); });
 }
 
 void Admin::markOrderDelivered() {
@@ -1015,22 +3438,15 @@ void Admin::markOrderDelivered() {
         cout << "Invalid ID." << endl;
         return;
     }
-    int oc = shopSystem->getOrderCount();
-    for (int i = 0; i < oc; ++i) {
-        Order& o = shopSystem->getOrderAt(i);
-        if (o.getId() == id) {
-            if (o.getStatus() == "Placed") {
-                o.setStatus("Delivered");
-                cout << " Order ID " << id << " marked as 'Delivered'." << endl;
-                shopSystem->saveData();  // Save after status change
-                return;
-            } else {
-                cout << " Order ID " << id << " is already " << o.getStatus() << "." << endl;
-                return;
-            }
-        }
+    int status;
+    if (shopSystem->changeOrderStatus(id, STATUS_PLACED, STATUS_DELIVERED, &status)) {
+        shopSystem->commitJournal();
+        cout << " Order ID " << id << " marked as 'Delivered'." << endl;
+    } else if (status < 0) {
+        cout << " Order ID " << id << " not found." << endl;
+    } else {
+        cout << " Order ID " << id << " is already " << ORDER_STATUS_NAMES[status] << "." << endl;
     }
-    cout << " Order ID " << id << " not found." << endl;
 }
 
 void Admin::searchCustomer() const {
@@ -1056,41 +3472,26 @@ void Admin::searchCustomer() const {
     }
 
     cout << "\n--- Search Results ---" << endl;
-    bool found = false;
-
-    User** users = shopSystem->getUsersArray();
-    int uc = shopSystem->getUserCount();
-
-    for (int i = 0; i < uc; ++i) {
-        Customer* customer = dynamic_cast<Customer*>(users[i]);
-        if (customer) {
-            bool matches = false;
-            if (searchType == 1 && customer->getUsername() == searchKey) matches = true;
-            if (searchType == 2 && customer->getAddress().find(searchKey) != string::npos && !searchKey.empty()) matches = true;
+    vector<Customer*> matches;
+    if (searchType == 1) {
+        Customer* customer = shopSystem->findCustomer(searchKey);
+        if (customer) matches.push_back(customer);
+    } else {
+        matches = shopSystem->findCustomersByAddress(searchKey);
+    }
 
-            if (matches) {
-                found = true;
-                cout << "Found Customer: " << customer->getUsername() << endl;
-                cout << "  - Last Known Address: " << customer->getAddress() << endl;
-
-                double totalSpent = 0.0;
-                int ordersCount = 0;
-                int oc = shopSystem->getOrderCount();
-                for (int j = 0; j < oc; ++j) {
-                    const Order& o = shopSystem->getOrderAt(j);
-                    if (o.getUsername() == customer->getUsername() && o.getStatus() != "Cancelled") {
-                        totalSpent += o.getTotalCost();
-                        ordersCount++;
-                    }
-                }
+    for (size_t i = 0; i < matches.size(); ++i) {
+        Customer* customer = matches[i];
+        cout << "Found Customer: " << customer->getUsername() << endl;
+        cout << "  - Last Known Address: " << customer->getAddress() << endl;
 
-                cout << "  - Total Orders Placed : " << ordersCount << endl;
-                cout << "  - Total Amount Shopped: PKR " << fixed << setprecision(2) << totalSpent << endl;
-            }
-        }
+        CustomerTotals totals = shopSystem->getCustomerTotals(customer->getUsername());
+        cout << "  - Total Orders Placed : " << totals.orders << endl;
+        cout << "  - Total Amount Shopped: PKR " << fixed << setprecision(2) << totals.spent << endl;
+        if (totals.lastOrderId > 0) cout << "  - Last Order ID     : " << totals.lastOrderId << endl;
     }
 
-    if (!found) {
+    if (matches.empty()) {
         cout << "No customers found matching the criteria." << endl;
     }
 }
@@ -1106,28 +3507,465 @@ void Admin::startSession() {
         cout << "5. View Product Inventory" << endl;
         cout << "6. View Category Summary" << endl;
         cout << "7. Save All Data" << endl;
-        cout << "8. Logout" << endl;
+        cout << "8. Top Customers" << endl;
+        cout << "9. Sales by Category" << endl;
+        cout << "10. Sales by Payment Method" << endl;
+        cout << "11. Sales by Delivery Type" << endl;
+        cout << "12. Sales by Order Status" << endl;
+        cout << "13. Logout" << endl;
         cout << "Enter choice: ";
         if (!(cin >> choice)) {
             cin.clear(); cin.ignore(10000, '\n');
             cout << "Invalid input. Please try again." << endl;
             continue;
         }
-        if (choice == 8) break;
+        if (choice == 13) break;
 
         switch (choice) {
             case 1: viewOrders(); break;
-            case 2: shopSystem->displayDeliveredOrders(); break;
+            case 2:
+                browsePages(shopSystem->countOrdersWithStatus(STATUS_DELIVERED), ORDERS_PER_PAGE,
+                            [this](size_t offset, size_t count) { shopSystem->displayDeliveredOrders(offset, count); });
+                break;
             case 3: markOrderDelivered(); break;
             case 4: searchCustomer(); break;
-            case 5: shopSystem->displayAllProducts(); break;
+            case 5:
+                browsePages(shopSystem->getProductCount(), PRODUCTS_PER_PAGE,
+                            [this](size_t offset, size_t count) { shopSystem->displayAllProducts(offset, count); });
+                break;
             case 6: shopSystem->displayCategorySummary(); break;
             case 7: shopSystem->saveData(); cout << "All data saved successfully!" << endl; break;
+            case 8: shopSystem->displayTopCustomers(TOP_CUSTOMERS_SHOWN); break;
+            case 9: shopSystem->displaySalesByCategory(); break;
+            case 10: shopSystem->displaySalesByPaymentMethod(); break;
+            case 11: shopSystem->displaySalesByDeliveryType(); break;
+            case 12: shopSystem->displaySalesByStatus(); break;
             default: cout << "Invalid option." << endl;
         }
     }
 }
 
+// ========== BATCH MODE ==========
+// Runs a stream of commands against the shop without prompts, one per line,
+// fields separated by '|' as in the data files:
+//   register|<username>|<password>      login|<username>|<password>
+//   logout|<username>                   add|<username>|<product ID>|<quantity>
+//   checkout|<username>|<advance or cod>|<normal or urgent>|<address>
+//   deliver|<order ID>                  search|<keywords>
+// Several users may be logged in at once, so captured traffic from many
+// sessions can be replayed in its original order. Carts and orders need
+// their user logged in; deliver needs an admin logged in. Blank lines and
+// lines starting with '#' are skipped.
+enum BatchOp : uint8_t {BATCH_REGISTER, BATCH_LOGIN, BATCH_LOGOUT, BATCH_ADD_TO_CART,
+                        BATCH_CHECKOUT, BATCH_MARK_DELIVERED, BATCH_SEARCH};
+const int NUM_BATCH_OPS = 7;
+const string BATCH_OP_NAMES[NUM_BATCH_OPS] = {"register", "login", "logout", "add", "checkout", "deliver", "search"};
+const int BATCH_OP_FIELDS[NUM_BATCH_OPS] = {3, 3, 2, 4, 5, 2, 2};
+const int BATCH_MAX_FIELDS = 5;
+const string PAYMENT_KEYWORDS[NUM_PAYMENT_METHODS] = {"advance", "cod"};
+const string DELIVERY_KEYWORDS[NUM_DELIVERY_TYPES] = {"normal", "urgent"};
+
+// One client's view of the shop: which users it has logged in. Batch mode
+// runs a whole file in one session; the server gives each connection one.
+// Sessions may run on different threads at once; a session itself is used
+// by one thread at a time.
+class CommandSession {
+    NTSHOP* shop;
+    unordered_set<const User*> loggedIn;
+    int adminsLoggedIn;
+
+    Customer* loggedInCustomer(string_view username) const {
+        Customer* c = shop->findCustomer(string(username));
+        return c && loggedIn.count(c) ? c : NULL;
+    }
+
+public:
+    explicit CommandSession(NTSHOP* s) : shop(s), adminsLoggedIn(0) {}
+
+    // Splits a command line into fields[0, BATCH_MAX_FIELDS) and returns its
+    // operation, or -1 with error set if it is not a complete command
+    static int parse(string_view line, string_view fields[], const char*& error) {
+        int count = splitFields(line, '|', fields, BATCH_MAX_FIELDS);
+        int op = lookupName(fields[0], BATCH_OP_NAMES, NUM_BATCH_OPS);
+        if (op < 0) error = "unknown command";
+        else if (count < BATCH_OP_FIELDS[op]) error = "missing fields";
+        else return op;
+        return -1;
+    }
+
+    // Returns whether the shop carried out the command. result is the new
+    // order's ID for checkout and the number of matches for search.
+    bool execute(BatchOp op, const string_view fields[], int& result) {
+        result = 0;
+        switch (op) {
+            case BATCH_REGISTER:
+                if (!shop->registerCustomer(string(fields[1]), string(fields[2]))) return false;
+                shop->commitJournal();
+                return true;
+            case BATCH_LOGIN: {
+                User* u = shop->findUser(string(fields[1]));
+                if (!u || u->getPassword() != fields[2] || !loggedIn.insert(u).second) return false;
+                if (dynamic_cast<Admin*>(u)) adminsLoggedIn++;
+                return true;
+            }
+            case BATCH_LOGOUT: {
+                User* u = shop->findUser(string(fields[1]));
+                if (!u || loggedIn.erase(u) == 0) return false;
+                if (dynamic_cast<Admin*>(u)) adminsLoggedIn--;
+                return true;
+            }
+            case BATCH_ADD_TO_CART: {
+                Customer* c = loggedInCustomer(fields[1]);
+                int productId, quantity;
+                if (!c || !parseInt(fields[2], productId) || !parseInt(fields[3], quantity)) return false;
+                lock_guard<mutex> lock(shop->customerLock(c->getUsername()));
+                return c->addToCart(shop->getProductById(productId), quantity);
+            }
+            case BATCH_CHECKOUT: {
+                Customer* c = loggedInCustomer(fields[1]);
+                int payment = lookupName(fields[2], PAYMENT_KEYWORDS, NUM_PAYMENT_METHODS);
+                int delivery = lookupName(fields[3], DELIVERY_KEYWORDS, NUM_DELIVERY_TYPES);
+                if (!c || payment < 0 || delivery < 0 || fields[4].empty()) return false;
+                lock_guard<mutex> lock(shop->customerLock(c->getUsername()));
+                result = c->placeCartOrder(string(fields[4]), (PaymentMethod)payment, (DeliveryType)delivery);
+                return result > 0;
+            }
+            case BATCH_MARK_DELIVERED: {
+                int id;
+                if (adminsLoggedIn == 0 || !parseInt(fields[1], id) ||
+                    !shop->changeOrderStatus(id, STATUS_PLACED, STATUS_DELIVERED)) return false;
+                shop->commitJournal();
+                return true;
+            }
+            case BATCH_SEARCH:
+                // No matches is an answer, not a failure
+                result = (int)shop->searchProducts(string(fields[1])).size();
+                return true;
+        }
+        return false;
+    }
+};
+
+class BatchRunner {
+    CommandSession session;
+    vector<double> timesNs[NUM_BATCH_OPS];
+    int failures[NUM_BATCH_OPS];
+    int rejectedLines;
+
+public:
+    explicit BatchRunner(NTSHOP* s) : session(s), failures(), rejectedLines(0) {}
+
+    // Runs every command in the file at path ("-" for standard input). The
+    // shop's own messages are suppressed; malformed lines go to cerr.
+    bool run(const string& path) {
+        LineReader reader(path == "-" ? "/dev/stdin" : path);
+        if (!reader.isOpen()) {
+            cout << "Cannot open command file " << path << "." << endl;
+            return false;
+        }
+        streambuf* console = cout.rdbuf(NULL);
+        string_view line;
+        int lineNumber = 0;
+        while (reader.next(line)) {
+            lineNumber++;
+            if (line.empty() || line[0] == '#') continue;
+
+            string_view fields[BATCH_MAX_FIELDS];
+            const char* error = NULL;
+            int op = CommandSession::parse(line, fields, error);
+            if (op < 0) {
+                cerr << "Line " << lineNumber << ": " << error << " in \"" << line << "\"" << endl;
+                rejectedLines++;
+                continue;
+            }
+
+            int result;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            bool ok = session.execute((BatchOp)op, fields, result);
+            timesNs[op].push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - start).count());
+            if (!ok) failures[op]++;
+        }
+        cout.clear();
+        cout.rdbuf(console);
+        return true;
+    }
+
+    // Per-operation count, failures and latency percentiles in microseconds
+    void printReport() {
+        cout << "\n--- Batch Report ---" << endl;
+        cout << setw(10) << "operation" << setw(10) << "count" << setw(8) << "failed" << setw(12) << "mean us"
+             << setw(12) << "p50 us" << setw(12) << "p99 us" << setw(12) << "max us" << endl;
+        size_t total = 0;
+        double totalNs = 0.0;
+        for (int op = 0; op < NUM_BATCH_OPS; ++op) {
+            vector<double>& times = timesNs[op];
+            if (times.empty()) continue;
+            sort(times.begin(), times.end());
+            double sum = 0.0;
+            for (size_t i = 0; i < times.size(); ++i) sum += times[i];
+            total += times.size();
+            totalNs += sum;
+            cout << setw(10) << BATCH_OP_NAMES[op] << setw(10) << times.size() << setw(8) << failures[op]
+                 << fixed << setprecision(2) << setw(12) << sum / times.size() / 1000
+                 << setw(12) << times[times.size() / 2] / 1000 << setw(12) << times[times.size() * 99 / 100] / 1000
+                 << setw(12) << times.back() / 1000 << endl;
+        }
+        cout << total << " operations in " << fixed << setprecision(2) << totalNs / 1e6 << " ms";
+        if (totalNs > 0) cout << " (" << setprecision(0) << total / (totalNs / 1e9) << " ops/s)";
+        cout << setprecision(2) << endl;
+        if (rejectedLines > 0) cout << rejectedLines << " lines rejected." << endl;
+    }
+};
+
+#ifdef NTSHOP_SERVER
+// ========== SERVER MODE ==========
+// Serves the batch commands over TCP on 127.0.0.1, one command per line. Each
+// reply is one line: "OK" (followed by the order ID for checkout or the match
+// count for search), "FAIL" if the shop refused, or "ERR <reason>" for a line
+// that is not a command. Each connection is its own CommandSession.
+//
+// One epoll thread waits on every connection. A readable connection is
+// handed to a fixed pool of workers, which read what has arrived, run the
+// complete lines in order and write the replies. EPOLLONESHOT keeps a
+// connection with one worker at a time, so its commands never reorder.
+// Commands from different connections run concurrently against NTSHOP.
+// A change is only acknowledged once it is on disk. Workers waiting for the
+// disk share journal syncs, so with many checkouts in flight it pays to run
+// more workers than cores and to give batches a short commit delay.
+const int SERVER_BACKLOG = 1024;
+const int SERVER_READ_CHUNK = 16384;
+const size_t SERVER_MAX_LINE = 65536;  // longer lines get "ERR line too long" and the connection is closed
+
+class ShopServer {
+    struct Connection {
+        int fd;
+        string input;   // bytes received after the last complete line
+        string output;  // replies not yet written
+        CommandSession session;
+        Connection(int f, NTSHOP* shop) : fd(f), session(shop) {}
+    };
+
+    NTSHOP* shop;
+    int listenFd, epollFd;
+    int workerCount;
+    atomic<bool> stopping;
+
+    mutex queueMutex;
+    condition_variable queueReady;
+    deque<Connection*> ready;
+    mutex connectionsMutex;
+    unordered_set<Connection*> connections;
+
+    void closeConnection(Connection* c) {
+        close(c->fd);  // also removes it from the epoll set
+        {
+            lock_guard<mutex> lock(connectionsMutex);
+            connections.erase(c);
+        }
+        delete c;
+    }
+
+    // Runs every complete line in c->input and queues the replies
+    void runCommands(Connection* c) {
+        size_t begin = 0, newline;
+        while ((newline = c->input.find('\n', begin)) != string::npos) {
+            string_view line(c->input.data() + begin, newline - begin);
+            begin = newline + 1;
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            if (line.empty()) continue;
+
+            string_view fields[BATCH_MAX_FIELDS];
+            const char* error = NULL;
+            int op = CommandSession::parse(line, fields, error);
+            if (op < 0) {
+                c->output += "ERR ";
+                c->output += error;
+                c->output += '\n';
+                continue;
+            }
+            int result;
+            bool ok = c->session.execute((BatchOp)op, fields, result);
+            if (!ok) {
+                c->output += "FAIL\n";
+            } else if (op == BATCH_CHECKOUT || op == BATCH_SEARCH) {
+                c->output += "OK ";
+                c->output += to_string(result);
+                c->output += '\n';
+            } else {
+                c->output += "OK\n";
+            }
+        }
+        c->input.erase(0, begin);
+    }
+
+    // Writes all of c->output, waiting for the socket if the client is slow
+    bool flushOutput(Connection* c) {
+        size_t sent = 0;
+        while (sent < c->output.size()) {
+            ssize_t n = send(c->fd, c->output.data() + sent, c->output.size() - sent, MSG_NOSIGNAL);
+            if (n > 0) {
+                sent += n;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                pollfd p = {c->fd, POLLOUT, 0};
+                if (poll(&p, 1, 1000) <= 0 && stopping) return false;
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else {
+                return false;
+            }
+        }
+        c->output.clear();
+        return true;
+    }
+
+    // Returns false once the client has closed the connection or it failed
+    bool serve(Connection* c) {
+        char chunk[SERVER_READ_CHUNK];
+        bool open = true;
+        while (true) {
+            ssize_t n = recv(c->fd, chunk, sizeof(chunk), 0);
+            if (n > 0) {
+                c->input.append(chunk, n);
+                runCommands(c);
+                // What is left is an unfinished line; an endless one would use up memory
+                if (c->input.size() > SERVER_MAX_LINE) {
+                    c->output += "ERR line too long\n";
+                    flushOutput(c);
+                    return false;
+                }
+                if ((size_t)n < sizeof(chunk)) break;
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else {
+                if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) open = false;
+                break;
+            }
+        }
+        // A last line without a newline still gets its answer on close
+        if (!open && !c->input.empty()) {
+            c->input += '\n';
+            runCommands(c);
+        }
+        return flushOutput(c) && open;
+    }
+
+    void workerLoop() {
+        while (true) {
+            Connection* c;
+            {
+                unique_lock<mutex> lock(queueMutex);
+                queueReady.wait(lock, [this] { return stopping || !ready.empty(); });
+                if (ready.empty()) return;
+                c = ready.front();
+                ready.pop_front();
+            }
+            if (!serve(c)) {
+                closeConnection(c);
+                continue;
+            }
+            epoll_event ev;
+            ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+            ev.data.ptr = c;
+            if (epoll_ctl(epollFd, EPOLL_CTL_MOD, c->fd, &ev) != 0) closeConnection(c);
+        }
+    }
+
+    void acceptAll() {
+        while (true) {
+            int fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return;
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            Connection* c = new Connection(fd, shop);
+            {
+                lock_guard<mutex> lock(connectionsMutex);
+                connections.insert(c);
+            }
+            epoll_event ev;
+            ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+            ev.data.ptr = c;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) != 0) closeConnection(c);
+        }
+    }
+
+public:
+    ShopServer(NTSHOP* s, int workers)
+        : shop(s), listenFd(-1), epollFd(-1), workerCount(max(1, workers)), stopping(false) {}
+
+    ~ShopServer() {
+        if (listenFd >= 0) close(listenFd);
+        if (epollFd >= 0) close(epollFd);
+    }
+
+    // Binds 127.0.0.1:port (0 picks a free port). Returns the bound port, or
+    // -1 with a message if the socket could not be set up.
+    int listenOn(int port) {
+        listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int one = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(addr);
+        if (listenFd < 0 || ::bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+            listen(listenFd, SERVER_BACKLOG) != 0 || getsockname(listenFd, (sockaddr*)&addr, &length) != 0) {
+            cout << "Cannot listen on port " << port << ": " << strerror(errno) << endl;
+            return -1;
+        }
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = NULL;  // marks the listening socket
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+        return ntohs(addr.sin_port);
+    }
+
+    // Serves until stop() is called (or stopFlag becomes nonzero)
+    void run(const volatile sig_atomic_t* stopFlag = NULL) {
+        vector<thread> workers;
+        for (int i = 0; i < workerCount; ++i) workers.emplace_back(&ShopServer::workerLoop, this);
+
+        epoll_event events[256];
+        while (!stopping && !(stopFlag && *stopFlag)) {
+            int n = epoll_wait(epollFd, events, 256, 100);
+            for (int i = 0; i < n; ++i) {
+                if (events[i].data.ptr == NULL) {
+                    acceptAll();
+                    continue;
+                }
+                {
+                    lock_guard<mutex> lock(queueMutex);
+                    ready.push_back((Connection*)events[i].data.ptr);
+                }
+                queueReady.notify_one();
+            }
+        }
+
+        {
+            lock_guard<mutex> lock(queueMutex);
+            stopping = true;
+        }
+        queueReady.notify_all();
+        for (size_t i = 0; i < workers.size(); ++i) workers[i].join();
+        for (unordered_set<Connection*>::iterator it = connections.begin(); it != connections.end(); ++it) {
+            close((*it)->fd);
+            delete *it;
+        }
+        connections.clear();
+        ready.clear();
+    }
+
+    void stop() {
+        {
+            lock_guard<mutex> lock(queueMutex);
+            stopping = true;
+        }
+        queueReady.notify_all();
+    }
+};
+#endif
+
 void runSystem(NTSHOP* shop) {
     string username, password;
     int roleChoice;
@@ -1164,8 +4002,8 @@ void runSystem(NTSHOP* shop) {
                 cin >> password;
                 
                 if (shop->registerCustomer(username, password)) {
+                    shop->commitJournal();
                     cout << "\n Customer '" << username << "' registered successfully!" << endl;
-                    shop->saveData();  // Save after registration
                     validRegistration = true;
                 } else {
                     cout << "\n Registration failed. Please try again." << endl;
@@ -1217,11 +4055,60 @@ void runSystem(NTSHOP* shop) {
     cout << "\nThank you for using N&T SHOP. Goodbye!" << endl;
 }
 
-int main() {
+#ifndef NTSHOP_NO_MAIN
+#ifdef NTSHOP_SERVER
+static volatile sig_atomic_t serverInterrupted = 0;
+
+static void onServerSignal(int) { serverInterrupted = 1; }
+#endif
+
+// Interactive by default; "--batch <file>" (or "-" for stdin) runs a
+// command file instead and prints the timing report, and
+// "--serve <port> [workers]" serves the same commands on 127.0.0.1 until
+// interrupted.
+int main(int argc, char* argv[]) {
     cout << fixed << setprecision(2);
     NTSHOP* shop = new NTSHOP();
+    if (argc == 3 && string(argv[1]) == "--batch") {
+        BatchRunner batch(shop);
+        bool ran = batch.run(argv[2]);
+        if (ran) batch.printReport();
+        delete shop;
+        return ran ? 0 : 1;
+    }
+    if (argc >= 3 && string(argv[1]) == "--serve") {
+#ifdef NTSHOP_SERVER
+        int port = 0, workers = (int)thread::hardware_concurrency(), commitDelay = DEFAULT_COMMIT_DELAY_US;
+        if (!parseInt(argv[2], port) || (argc > 3 && !parseInt(argv[3], workers)) ||
+            (argc > 4 && !parseInt(argv[4], commitDelay))) {
+            cout << "Usage: --serve <port> [workers] [commit delay in microseconds]" << endl;
+            delete shop;
+            return 1;
+        }
+        shop->setCommitDelay(commitDelay);
+        ShopServer server(shop, workers);
+        port = server.listenOn(port);
+        if (port < 0) {
+            delete shop;
+            return 1;
+        }
+        signal(SIGINT, onServerSignal);
+        signal(SIGTERM, onServerSignal);
+        cout << "Serving on 127.0.0.1:" << port << " with " << max(1, workers) << " workers. Ctrl+C stops." << endl;
+        streambuf* console = cout.rdbuf(NULL);  // the shop's own messages
+        server.run(&serverInterrupted);
+        cout.clear();
+        cout.rdbuf(console);
+        cout << "Server stopped." << endl;
+#else
+        cout << "Server mode needs Linux." << endl;
+#endif
+        delete shop;
+        return 0;
+    }
     runSystem(shop);
     delete shop;
-    sysrtem("pause");
+    system("pause");
     return 0;
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file